@@ -0,0 +1,165 @@
+#ifndef ASSETFILE_H
+#define ASSETFILE_H
+
+// Pliki zasobów (shadery, siatki) mapowane do pamięci tylko do odczytu zamiast kopiowania przez
+// fread do bufora na stercie. Zmapowane pliki trzymane są w puli tylko do assetPoolRelease -
+// ponowne pobranie tego samego pliku w tym czasie (np. wspólny #include w shaderze wierzchołków
+// i fragmentów) nic nie kosztuje. Wywołujący zwalnia pulę, gdy tylko widoki zostaną zużyte
+// (np. po glShaderSource): w Windows pliku ze zmapowanym widokiem nie da się skrócić ani zastąpić,
+// więc edytor nie zapisałby shadera. Każde budowanie po zwolnieniu mapuje aktualną zawartość.
+// Widok (AssetView) nie kończy się znakiem NUL - długość trzeba przekazywać jawnie
+// (np. w tablicy lengths glShaderSource). Widok jest ważny do ponownego pobrania tego samego
+// pliku z puli albo do assetPoolRelease / assetPoolFree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+// glad definiuje już APIENTRY - windows.h definiuje je ponownie tak samo (__stdcall)
+#undef APIENTRY
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN     // OpenGL2.vcxproj przekazuje je też przez /D
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define ASSET_PATH_MAX 256
+
+typedef struct {
+    const char* data;
+    int length;
+} AssetView;
+
+typedef struct {
+    char path[ASSET_PATH_MAX];
+    const char* data;       // NULL dla pustego pliku
+    size_t size;
+    time_t mtime;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
+} AssetMapping;
+
+typedef struct {
+    AssetMapping* mappings;
+    int count, capacity;
+} AssetPool;
+
+static inline void assetPoolInit(AssetPool* pool) {
+    memset(pool, 0, sizeof(*pool));
+}
+
+static inline void assetUnmap(AssetMapping* mapping) {
+#ifdef _WIN32
+    if (mapping->data) UnmapViewOfFile(mapping->data);
+    if (mapping->mapping) CloseHandle(mapping->mapping);
+    if (mapping->file != INVALID_HANDLE_VALUE && mapping->file) CloseHandle(mapping->file);
+    mapping->file = mapping->mapping = NULL;
+#else
+    if (mapping->data) munmap((void*)mapping->data, mapping->size);
+#endif
+    mapping->data = NULL;
+    mapping->size = 0;
+}
+
+// Zwraca 0 gdy pliku nie da się otworzyć lub zmapować
+static inline int assetMap(AssetMapping* mapping, const char* path, size_t size) {
+    mapping->data = NULL;
+    mapping->size = size;
+    if (size == 0)
+        return 1;   // pustego pliku nie da się zmapować, a nie ma też czego czytać
+#ifdef _WIN32
+    mapping->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        mapping->file = NULL;
+        return 0;
+    }
+    mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping->mapping)
+        mapping->data = (const char*)MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, size);
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // mapowanie trzyma plik i bez deskryptora
+    if (data != MAP_FAILED)
+        mapping->data = (const char*)data;
+#endif
+    if (!mapping->data) {
+        assetUnmap(mapping);
+        return 0;
+    }
+    return 1;
+}
+
+// Widok zawartości pliku; zwraca 0 (i wypisuje błąd) gdy pliku nie da się wczytać
+static inline int assetPoolGet(AssetPool* pool, const char* path, AssetView* view) {
+    struct stat info;
+    if (stat(path, &info) != 0 || info.st_size > 0x7FFFFFFF) {
+        fprintf(stderr, "Nie można otworzyć pliku: %s\n", path);
+        return 0;
+    }
+    AssetMapping* mapping = NULL;
+    for (int i = 0; i < pool->count; i++) {
+        if (strcmp(pool->mappings[i].path, path) == 0) {
+            mapping = &pool->mappings[i];
+            break;
+        }
+    }
+    if (mapping && (mapping->size != (size_t)info.st_size || mapping->mtime != info.st_mtime)) {
+        assetUnmap(mapping);
+    } else if (mapping) {
+        view->data = mapping->data ? mapping->data : "";
+        view->length = (int)mapping->size;
+        return 1;
+    } else {
+        if (pool->count == pool->capacity) {
+            int capacity = pool->capacity ? pool->capacity * 2 : 16;
+            AssetMapping* mappings = (AssetMapping*)realloc(pool->mappings, capacity * sizeof(AssetMapping));
+            if (!mappings)
+                return 0;
+            pool->mappings = mappings;
+            pool->capacity = capacity;
+        }
+        mapping = &pool->mappings[pool->count++];
+        memset(mapping, 0, sizeof(*mapping));
+        snprintf(mapping->path, sizeof(mapping->path), "%s", path);
+    }
+
+    mapping->mtime = info.st_mtime;
+    if (!assetMap(mapping, path, (size_t)info.st_size)) {
+        fprintf(stderr, "Nie można zmapować pliku: %s\n", path);
+        mapping->mtime = 0;     // następna próba zmapuje od nowa
+        return 0;
+    }
+    view->data = mapping->data ? mapping->data : "";
+    view->length = (int)mapping->size;
+    return 1;
+}
+
+// Odmapowanie wszystkich plików - widoki z puli przestają być ważne, pliki można znowu zapisywać
+static inline void assetPoolRelease(AssetPool* pool) {
+    for (int i = 0; i < pool->count; i++)
+        assetUnmap(&pool->mappings[i]);
+    pool->count = 0;
+}
+
+static inline void assetPoolFree(AssetPool* pool) {
+    for (int i = 0; i < pool->count; i++)
+        assetUnmap(&pool->mappings[i]);
+    free(pool->mappings);
+    memset(pool, 0, sizeof(*pool));
+}
+
+#endif
@@ -0,0 +1,359 @@
+#ifndef BVH_H
+#define BVH_H
+
+// Hierarchia brył otaczających (BVH) nad prostopadłościanami obiektów sceny.
+// Budowa metodą binned SAH, hierarchiczne obcinanie do bryły widzenia i zapytania promieniem (wybieranie obiektów).
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "linmath.h"
+#include "frustum.h"
+
+#define BVH_BINS 12
+#define BVH_MAX_LEAF 4
+#define BVH_MAX_DEPTH 255   // głębsze węzły zostają liśćmi
+// Przy przechodzeniu na stosie czeka najwyżej jeden węzeł z każdego poziomu nad bieżącym
+// i dwoje dzieci bieżącego, więc stos o rozmiarze BVH_MAX_DEPTH + 1 nigdy się nie przepełni
+#define BVH_STACK_SIZE (BVH_MAX_DEPTH + 1)
+
+typedef struct {
+    vec3 boundsMin, boundsMax;
+    int left;       // indeks lewego dziecka (prawe to left + 1), -1 dla liścia
+    int first;      // zakres prymitywów poddrzewa w tablicy indices
+    int count;
+} BvhNode;
+
+typedef struct {
+    BvhNode* nodes;
+    int numNodes;
+    int* indices;   // numery obiektów ułożone tak, że każde poddrzewo to ciągły zakres
+    vec3* primMin;  // prostopadłościany obiektów (numeracja oryginalna)
+    vec3* primMax;
+    vec3* centroids;
+    int numPrims;
+} Bvh;
+
+static inline void bvhInit(Bvh* bvh) {
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+static inline void bvhFree(Bvh* bvh) {
+    free(bvh->nodes);
+    free(bvh->indices);
+    free(bvh->primMin);
+    free(bvh->primMax);
+    free(bvh->centroids);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+static inline float bvhBoxArea(vec3 const boxMin, vec3 const boxMax) {
+    float dx = boxMax[0] - boxMin[0], dy = boxMax[1] - boxMin[1], dz = boxMax[2] - boxMin[2];
+    if (dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f; // pusty przedział
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static inline void bvhBoxEmpty(vec3 boxMin, vec3 boxMax) {
+    for (int k = 0; k < 3; k++) {
+        boxMin[k] = INFINITY;
+        boxMax[k] = -INFINITY;
+    }
+}
+
+static inline void bvhBoxGrow(vec3 boxMin, vec3 boxMax, vec3 const otherMin, vec3 const otherMax) {
+    for (int k = 0; k < 3; k++) {
+        if (otherMin[k] < boxMin[k]) boxMin[k] = otherMin[k];
+        if (otherMax[k] > boxMax[k]) boxMax[k] = otherMax[k];
+    }
+}
+
+static inline void bvhUpdateNodeBounds(Bvh* bvh, BvhNode* node) {
+    bvhBoxEmpty(node->boundsMin, node->boundsMax);
+    for (int i = node->first; i < node->first + node->count; i++) {
+        int prim = bvh->indices[i];
+        bvhBoxGrow(node->boundsMin, node->boundsMax, bvh->primMin[prim], bvh->primMax[prim]);
+    }
+}
+
+// Wybór podziału metodą SAH na BVH_BINS przedziałach wzdłuż każdej osi.
+// Zwraca koszt najlepszego podziału (INFINITY gdy nie da się podzielić).
+static inline float bvhFindSplit(const Bvh* bvh, const BvhNode* node, int* bestAxis, float* bestPos) {
+    float bestCost = INFINITY;
+    for (int axis = 0; axis < 3; axis++) {
+        float cMin = INFINITY, cMax = -INFINITY;
+        for (int i = node->first; i < node->first + node->count; i++) {
+            float c = bvh->centroids[bvh->indices[i]][axis];
+            if (c < cMin) cMin = c;
+            if (c > cMax) cMax = c;
+        }
+        if (cMax <= cMin) continue;
+
+        vec3 binMin[BVH_BINS], binMax[BVH_BINS];
+        int binCount[BVH_BINS] = { 0 };
+        for (int b = 0; b < BVH_BINS; b++)
+            bvhBoxEmpty(binMin[b], binMax[b]);
+        float scale = BVH_BINS / (cMax - cMin);
+        for (int i = node->first; i < node->first + node->count; i++) {
+            int prim = bvh->indices[i];
+            int b = (int)((bvh->centroids[prim][axis] - cMin) * scale);
+            if (b > BVH_BINS - 1) b = BVH_BINS - 1;
+            binCount[b]++;
+            bvhBoxGrow(binMin[b], binMax[b], bvh->primMin[prim], bvh->primMax[prim]);
+        }
+
+        // Powierzchnie i liczności lewej strony liczone od lewej, prawej od prawej
+        float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+        int leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+        vec3 accMin, accMax;
+        int acc = 0;
+        bvhBoxEmpty(accMin, accMax);
+        for (int b = 0; b < BVH_BINS - 1; b++) {
+            acc += binCount[b];
+            bvhBoxGrow(accMin, accMax, binMin[b], binMax[b]);
+            leftCount[b] = acc;
+            leftArea[b] = bvhBoxArea(accMin, accMax);
+        }
+        acc = 0;
+        bvhBoxEmpty(accMin, accMax);
+        for (int b = BVH_BINS - 1; b > 0; b--) {
+            acc += binCount[b];
+            bvhBoxGrow(accMin, accMax, binMin[b], binMax[b]);
+            rightCount[b - 1] = acc;
+            rightArea[b - 1] = bvhBoxArea(accMin, accMax);
+        }
+
+        for (int b = 0; b < BVH_BINS - 1; b++) {
+            if (leftCount[b] == 0 || rightCount[b] == 0) continue;
+            float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                *bestAxis = axis;
+                *bestPos = cMin + (b + 1) / scale;
+            }
+        }
+    }
+    return bestCost;
+}
+
+// Budowa drzewa dla count obiektów o prostopadłościanach boxMin[i]..boxMax[i].
+// Zwraca 0 gdy zabrakło pamięci.
+static inline int bvhBuild(Bvh* bvh, const vec3* boxMin, const vec3* boxMax, int count) {
+    bvhFree(bvh);
+    if (count <= 0) return 1;
+
+    bvh->numPrims = count;
+    bvh->nodes = (BvhNode*)malloc(sizeof(BvhNode) * (2 * count - 1));
+    bvh->indices = (int*)malloc(sizeof(int) * count);
+    bvh->primMin = (vec3*)malloc(sizeof(vec3) * count);
+    bvh->primMax = (vec3*)malloc(sizeof(vec3) * count);
+    bvh->centroids = (vec3*)malloc(sizeof(vec3) * count);
+    if (!bvh->nodes || !bvh->indices || !bvh->primMin || !bvh->primMax || !bvh->centroids) {
+        bvhFree(bvh);
+        return 0;
+    }
+
+    memcpy(bvh->primMin, boxMin, sizeof(vec3) * count);
+    memcpy(bvh->primMax, boxMax, sizeof(vec3) * count);
+    for (int i = 0; i < count; i++) {
+        bvh->indices[i] = i;
+        for (int k = 0; k < 3; k++)
+            bvh->centroids[i][k] = 0.5f * (boxMin[i][k] + boxMax[i][k]);
+    }
+
+    BvhNode* root = &bvh->nodes[0];
+    root->left = -1;
+    root->first = 0;
+    root->count = count;
+    bvhUpdateNodeBounds(bvh, root);
+    bvh->numNodes = 1;
+
+    // Podział węzłów w kolejności przechodzenia w głąb - dzieci zawsze za rodzicem
+    int stack[BVH_STACK_SIZE];
+    int stackDepth[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stackDepth[stackSize] = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        --stackSize;
+        BvhNode* node = &bvh->nodes[stack[stackSize]];
+        int depth = stackDepth[stackSize];
+        if (node->count <= 2 || depth == BVH_MAX_DEPTH) continue;
+
+        int axis = 0;
+        float pos = 0.0f;
+        float splitCost = bvhFindSplit(bvh, node, &axis, &pos);
+        float leafCost = node->count * bvhBoxArea(node->boundsMin, node->boundsMax);
+        if (node->count <= BVH_MAX_LEAF && splitCost >= leafCost) continue;
+
+        int mid;
+        if (splitCost < INFINITY) {
+            // Podział w miejscu: prymitywy z centroidem przed pos na lewo
+            int i = node->first;
+            int j = node->first + node->count - 1;
+            while (i <= j) {
+                if (bvh->centroids[bvh->indices[i]][axis] < pos) {
+                    i++;
+                } else {
+                    int tmp = bvh->indices[i];
+                    bvh->indices[i] = bvh->indices[j];
+                    bvh->indices[j--] = tmp;
+                }
+            }
+            mid = i;
+        } else {
+            mid = node->first + node->count / 2; // identyczne centroidy - dzielimy po liczbie
+        }
+        if (mid == node->first || mid == node->first + node->count) continue;
+
+        int leftIndex = bvh->numNodes;
+        BvhNode* left = &bvh->nodes[leftIndex];
+        BvhNode* right = &bvh->nodes[leftIndex + 1];
+        left->left = right->left = -1;
+        left->first = node->first;
+        left->count = mid - node->first;
+        right->first = mid;
+        right->count = node->first + node->count - mid;
+        bvhUpdateNodeBounds(bvh, left);
+        bvhUpdateNodeBounds(bvh, right);
+        node->left = leftIndex;
+        bvh->numNodes += 2;
+
+        assert(stackSize + 2 <= BVH_STACK_SIZE);
+        stackDepth[stackSize] = depth + 1;
+        stack[stackSize++] = leftIndex + 1;
+        stackDepth[stackSize] = depth + 1;
+        stack[stackSize++] = leftIndex;
+    }
+    return 1;
+}
+
+// Obcinanie hierarchiczne. Maska bitowa płaszczyzn przecinanych przez węzeł jest dziedziczona,
+// a węzeł w całości wewnątrz dodaje cały swój zakres indeksów bez dalszych testów.
+// Zwraca liczbę widocznych obiektów zapisanych do visibleIndices.
+static inline int bvhCullFrustum(const Bvh* bvh, const Frustum* frustum, int* visibleIndices) {
+    if (bvh->numNodes == 0) return 0;
+
+    int visible = 0;
+    int stackNode[BVH_STACK_SIZE];
+    int stackMask[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stackNode[stackSize] = 0;
+    stackMask[stackSize++] = 0x3F;
+
+    while (stackSize > 0) {
+        --stackSize;
+        const BvhNode* node = &bvh->nodes[stackNode[stackSize]];
+        int mask = stackMask[stackSize];
+        int outside = 0;
+
+        for (int p = 0; p < 6; p++) {
+            if (!(mask & (1 << p))) continue;
+            const float* plane = frustum->planes[p];
+            // wierzchołek najdalej wzdłuż normalnej (p) i najbliżej (n)
+            float px = plane[0] >= 0.0f ? node->boundsMax[0] : node->boundsMin[0];
+            float py = plane[1] >= 0.0f ? node->boundsMax[1] : node->boundsMin[1];
+            float pz = plane[2] >= 0.0f ? node->boundsMax[2] : node->boundsMin[2];
+            if (plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < 0.0f) {
+                outside = 1;
+                break;
+            }
+            float nx = plane[0] >= 0.0f ? node->boundsMin[0] : node->boundsMax[0];
+            float ny = plane[1] >= 0.0f ? node->boundsMin[1] : node->boundsMax[1];
+            float nz = plane[2] >= 0.0f ? node->boundsMin[2] : node->boundsMax[2];
+            if (plane[0] * nx + plane[1] * ny + plane[2] * nz + plane[3] >= 0.0f)
+                mask &= ~(1 << p); // w całości po wewnętrznej stronie tej płaszczyzny
+        }
+        if (outside) continue;
+
+        if (mask == 0) {
+            memcpy(visibleIndices + visible, bvh->indices + node->first, sizeof(int) * node->count);
+            visible += node->count;
+        } else if (node->left < 0) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                int prim = bvh->indices[i];
+                if (frustumTestBox(frustum, bvh->primMin[prim], bvh->primMax[prim]))
+                    visibleIndices[visible++] = prim;
+            }
+        } else {
+            assert(stackSize + 2 <= BVH_STACK_SIZE);
+            stackNode[stackSize] = node->left;
+            stackMask[stackSize++] = mask;
+            stackNode[stackSize] = node->left + 1;
+            stackMask[stackSize++] = mask;
+        }
+    }
+    return visible;
+}
+
+// Przecięcie promienia z prostopadłościanem (metoda płyt); invDir = 1 / kierunek
+static inline int bvhRayBox(vec3 const origin, vec3 const invDir, vec3 const boxMin, vec3 const boxMax,
+                            float maxT, float* tHit) {
+    float tNear = 0.0f, tFar = maxT;
+    for (int k = 0; k < 3; k++) {
+        float t0 = (boxMin[k] - origin[k]) * invDir[k];
+        float t1 = (boxMax[k] - origin[k]) * invDir[k];
+        if (t0 > t1) { float tmp = t0; t0 = t1; t1 = tmp; }
+        if (t0 > tNear) tNear = t0;
+        if (t1 < tFar) tFar = t1;
+        if (tNear > tFar) return 0;
+    }
+    *tHit = tNear;
+    return 1;
+}
+
+// Najbliższy obiekt trafiony promieniem origin + t * dir (t <= maxT).
+// Zwraca numer obiektu lub -1, odległość trafienia w *hitT.
+static inline int bvhRaycast(const Bvh* bvh, vec3 const origin, vec3 const dir, float maxT, float* hitT) {
+    if (bvh->numNodes == 0) return -1;
+
+    vec3 invDir;
+    for (int k = 0; k < 3; k++)
+        invDir[k] = 1.0f / dir[k]; // dzielenie przez 0 daje nieskończoność, co test płyt obsługuje
+
+    int hit = -1;
+    float closest = maxT;
+    int stack[BVH_STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const BvhNode* node = &bvh->nodes[stack[--stackSize]];
+        float t;
+        if (!bvhRayBox(origin, invDir, node->boundsMin, node->boundsMax, closest, &t)) continue;
+
+        if (node->left < 0) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                int prim = bvh->indices[i];
+                if (bvhRayBox(origin, invDir, bvh->primMin[prim], bvh->primMax[prim], closest, &t)) {
+                    closest = t;
+                    hit = prim;
+                }
+            }
+            continue;
+        }
+
+        // Bliższe dziecko na wierzch stosu, żeby szybciej zawęzić closest
+        float tLeft, tRight;
+        const BvhNode* left = &bvh->nodes[node->left];
+        const BvhNode* right = &bvh->nodes[node->left + 1];
+        int hitLeft = bvhRayBox(origin, invDir, left->boundsMin, left->boundsMax, closest, &tLeft);
+        int hitRight = bvhRayBox(origin, invDir, right->boundsMin, right->boundsMax, closest, &tRight);
+        assert(stackSize + 2 <= BVH_STACK_SIZE);
+        if (hitLeft && hitRight) {
+            int nearFirst = tLeft <= tRight;
+            stack[stackSize++] = nearFirst ? node->left + 1 : node->left;
+            stack[stackSize++] = nearFirst ? node->left : node->left + 1;
+        } else if (hitLeft) {
+            stack[stackSize++] = node->left;
+        } else if (hitRight) {
+            stack[stackSize++] = node->left + 1;
+        }
+    }
+
+    if (hit >= 0) *hitT = closest;
+    return hit;
+}
+
+#endif
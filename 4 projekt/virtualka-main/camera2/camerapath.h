@@ -0,0 +1,174 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+// Nagrywanie i odtwarzanie ścieżki kamery do powtarzalnych pomiarów.
+// Nagranie: w każdej klatce pozycja, yaw, pitch i FOV kamery oraz pozycja światła trafiają do pamięci,
+// a przy wyjściu do pliku binarnego (nagłówek + tablica klatek, little-endian).
+// Odtwarzanie: kamera i światło ustawiane są z pliku klatka po klatce ze stałym krokiem czasu
+// niezależnym od zegara, a po ostatniej klatce wypisywane są min/średni/p99 czasu klatki.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define CAMERA_PATH_MAGIC 0x48544150u   // "PATH"
+#define CAMERA_PATH_VERSION 1u
+#define CAMERA_PATH_TIMESTEP (1.0f / 60.0f)
+
+enum CameraPathMode {
+    PATH_OFF,
+    PATH_RECORD,
+    PATH_REPLAY
+};
+
+typedef struct {
+    float position[3];
+    float yaw, pitch, fov;
+    float light[3];
+} CameraPathFrame;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frameCount;
+    float timestep;     // krok czasu symulacji przy odtwarzaniu
+} CameraPathHeader;
+
+typedef struct {
+    int mode;
+    const char* fileName;
+    CameraPathFrame* frames;
+    int count;
+    int capacity;
+    int cursor;         // następna klatka do odtworzenia
+    float timestep;
+    double* frameMs;    // czasy klatek przy odtwarzaniu
+    double lastFrameTime;
+} CameraPath;
+
+static inline void cameraPathInit(CameraPath* path) {
+    memset(path, 0, sizeof(*path));
+    path->timestep = CAMERA_PATH_TIMESTEP;
+    path->lastFrameTime = -1.0;
+}
+
+static inline void cameraPathFree(CameraPath* path) {
+    free(path->frames);
+    free(path->frameMs);
+    path->frames = NULL;
+    path->frameMs = NULL;
+    path->count = path->capacity = 0;
+}
+
+// Wczytanie nagrania do odtworzenia; zwraca 0 przy błędzie
+static inline int cameraPathLoad(CameraPath* path, const char* fileName) {
+    FILE* file = fopen(fileName, "rb");
+    if (!file) {
+        fprintf(stderr, "Nie można otworzyć nagrania %s\n", fileName);
+        return 0;
+    }
+    CameraPathHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != CAMERA_PATH_MAGIC ||
+        header.version != CAMERA_PATH_VERSION || header.frameCount == 0) {
+        fprintf(stderr, "Niepoprawny plik nagrania %s\n", fileName);
+        fclose(file);
+        return 0;
+    }
+    path->frames = (CameraPathFrame*)malloc(sizeof(CameraPathFrame) * header.frameCount);
+    path->frameMs = (double*)malloc(sizeof(double) * header.frameCount);
+    if (!path->frames || !path->frameMs ||
+        fread(path->frames, sizeof(CameraPathFrame), header.frameCount, file) != header.frameCount) {
+        fprintf(stderr, "Nie można wczytać %u klatek z %s\n", header.frameCount, fileName);
+        fclose(file);
+        cameraPathFree(path);
+        return 0;
+    }
+    fclose(file);
+    path->mode = PATH_REPLAY;
+    path->fileName = fileName;
+    path->count = path->capacity = (int)header.frameCount;
+    path->cursor = 0;
+    path->timestep = header.timestep > 0.0f ? header.timestep : CAMERA_PATH_TIMESTEP;
+    return 1;
+}
+
+static inline void cameraPathStartRecording(CameraPath* path, const char* fileName) {
+    path->mode = PATH_RECORD;
+    path->fileName = fileName;
+}
+
+// Dopisanie klatki do nagrania (tablica rośnie dwukrotnie)
+static inline void cameraPathRecord(CameraPath* path, const CameraPathFrame* frame) {
+    if (path->count == path->capacity) {
+        int capacity = path->capacity ? path->capacity * 2 : 1024;
+        CameraPathFrame* frames = (CameraPathFrame*)realloc(path->frames, sizeof(CameraPathFrame) * capacity);
+        if (!frames) {
+            fprintf(stderr, "Brak pamięci na nagranie kamery - nagrywanie przerwane\n");
+            path->mode = PATH_OFF;
+            return;
+        }
+        path->frames = frames;
+        path->capacity = capacity;
+    }
+    path->frames[path->count++] = *frame;
+}
+
+// Zapis nagrania na dysk; zwraca 0 przy błędzie
+static inline int cameraPathSave(const CameraPath* path) {
+    FILE* file = fopen(path->fileName, "wb");
+    if (!file) {
+        fprintf(stderr, "Nie można zapisać nagrania %s\n", path->fileName);
+        return 0;
+    }
+    CameraPathHeader header;
+    header.magic = CAMERA_PATH_MAGIC;
+    header.version = CAMERA_PATH_VERSION;
+    header.frameCount = (uint32_t)path->count;
+    header.timestep = path->timestep;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(path->frames, sizeof(CameraPathFrame), path->count, file) == (size_t)path->count;
+    fclose(file);
+    if (ok)
+        printf("Zapisano %d klatek ścieżki kamery do %s\n", path->count, path->fileName);
+    else
+        fprintf(stderr, "Błąd zapisu nagrania %s\n", path->fileName);
+    return ok;
+}
+
+// Następna klatka odtwarzania; zwraca 0 gdy nagranie się skończyło
+static inline int cameraPathNext(CameraPath* path, CameraPathFrame* frame) {
+    if (path->cursor >= path->count)
+        return 0;
+    *frame = path->frames[path->cursor++];
+    return 1;
+}
+
+// Wywoływane raz na klatkę przy odtwarzaniu - czas od poprzedniego wywołania
+static inline void cameraPathFrameDone(CameraPath* path, double now) {
+    if (path->lastFrameTime >= 0.0 && path->cursor >= 1)
+        path->frameMs[path->cursor - 1] = (now - path->lastFrameTime) * 1000.0;
+    path->lastFrameTime = now;
+}
+
+static inline int cameraPathCompareMs(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Podsumowanie odtwarzania: min / średni / p99 czasu klatki (pierwsza klatka bez pomiaru)
+static inline void cameraPathReport(CameraPath* path) {
+    int n = path->cursor - 1;
+    if (path->mode != PATH_REPLAY || n < 1)
+        return;
+    double* sorted = path->frameMs + 1;
+    qsort(sorted, n, sizeof(double), cameraPathCompareMs);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+        sum += sorted[i];
+    int p99 = (int)(0.99 * (n - 1) + 0.5);
+    printf("Odtworzono %d klatek z %s: min %.3f ms, średnio %.3f ms, p99 %.3f ms\n",
+           path->cursor, path->fileName, sorted[0], sum / n, sorted[p99]);
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef FILEWATCH_H
+#define FILEWATCH_H
+
+// Obserwacja plików w katalogu bez blokowania pętli głównej.
+// Linux: inotify w trybie nieblokującym - zdarzenia po zamknięciu zapisanego pliku i po podmianie
+// przez rename (tak zapisuje wiele edytorów). Pozostałe systemy: porównanie czasów modyfikacji
+// zarejestrowanych plików, nie częściej niż co FILE_WATCH_POLL_INTERVAL sekund.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define FILE_WATCH_MAX_FILES 32
+#define FILE_WATCH_NAME_MAX 64
+#define FILE_WATCH_POLL_INTERVAL 0.25
+
+typedef struct {
+    const char* dir;
+    char names[FILE_WATCH_MAX_FILES][FILE_WATCH_NAME_MAX];  // obserwowane pliki (nazwy w katalogu)
+    time_t mtimes[FILE_WATCH_MAX_FILES];
+    int numFiles;
+    double lastPoll;
+#if defined(__linux__)
+    int fd;                 // -1 = brak inotify
+#endif
+} FileWatch;
+
+static inline time_t fileWatchModified(const FileWatch* watch, const char* name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", watch->dir, name);
+    struct stat info;
+    return stat(path, &info) == 0 ? info.st_mtime : 0;
+}
+
+// Zwraca 0 gdy katalogu nie da się obserwować
+static inline int fileWatchInit(FileWatch* watch, const char* dir) {
+    memset(watch, 0, sizeof(*watch));
+    watch->dir = dir;
+#if defined(__linux__)
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd < 0 || inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Nie można obserwować katalogu %s\n", dir);
+        if (watch->fd >= 0) close(watch->fd);
+        watch->fd = -1;
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+static inline void fileWatchFree(FileWatch* watch) {
+#if defined(__linux__)
+    if (watch->fd >= 0) close(watch->fd);
+    watch->fd = -1;
+#endif
+    watch->numFiles = 0;
+}
+
+// Plik, o którego zmianach chcemy wiedzieć (nazwa względem katalogu)
+static inline void fileWatchAdd(FileWatch* watch, const char* name) {
+    for (int i = 0; i < watch->numFiles; i++) {
+        if (strcmp(watch->names[i], name) == 0)
+            return;
+    }
+    if (watch->numFiles == FILE_WATCH_MAX_FILES)
+        return;
+    snprintf(watch->names[watch->numFiles], FILE_WATCH_NAME_MAX, "%s", name);
+    watch->mtimes[watch->numFiles] = fileWatchModified(watch, name);
+    watch->numFiles++;
+}
+
+// Nazwa pliku względem obserwowanego katalogu ("katalog/plik" -> "plik") albo NULL, gdy jest poza nim
+static inline const char* fileWatchName(const FileWatch* watch, const char* path) {
+    size_t length = strlen(watch->dir);
+    if (strncmp(path, watch->dir, length) != 0 || path[length] != '/' || strchr(path + length + 1, '/'))
+        return NULL;
+    return path + length + 1;
+}
+
+// Nazwy zmienionych plików od poprzedniego wywołania (bez powtórzeń); now - bieżący czas w sekundach.
+// Zwraca ich liczbę, nigdy nie czeka.
+static inline int fileWatchPoll(FileWatch* watch, double now, char changed[][FILE_WATCH_NAME_MAX], int maxChanged) {
+    int count = 0;
+#if defined(__linux__)
+    (void)now;
+    if (watch->fd < 0)
+        return 0;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t length = read(watch->fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;  // EAGAIN - nic więcej nie czeka
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+            int known = 0, duplicate = 0;
+            for (int i = 0; i < watch->numFiles; i++)
+                known |= strcmp(watch->names[i], event->name) == 0;
+            for (int i = 0; i < count; i++)
+                duplicate |= strcmp(changed[i], event->name) == 0;
+            if (known && !duplicate && count < maxChanged)
+                snprintf(changed[count++], FILE_WATCH_NAME_MAX, "%s", event->name);
+        }
+    }
+#else
+    if (now - watch->lastPoll < FILE_WATCH_POLL_INTERVAL)
+        return 0;
+    watch->lastPoll = now;
+    for (int i = 0; i < watch->numFiles && count < maxChanged; i++) {
+        time_t modified = fileWatchModified(watch, watch->names[i]);
+        if (modified != watch->mtimes[i]) {
+            watch->mtimes[i] = modified;
+            snprintf(changed[count++], FILE_WATCH_NAME_MAX, "%s", watch->names[i]);
+        }
+    }
+#endif
+    return count;
+}
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+// Obcinanie obiektów poza bryłą widzenia (frustum culling)
+// Płaszczyzny są wyciągane z iloczynu P*V, obiekty są sferami trzymanymi jako
+// struktura tablic (x[], y[], z[], r[]), dzięki czemu test idzie paczkami po 4 (SSE) lub 8 (AVX).
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "linmath.h"
+
+// Szerokość paczki według backendu linmath.h, więc LINMATH_NO_SIMD wyłącza też SIMD tutaj
+#if defined(LINMATH_SIMD_AVX)
+#define FRUSTUM_SIMD_WIDTH 8
+#elif defined(LINMATH_SIMD_SSE)
+#define FRUSTUM_SIMD_WIDTH 4
+#else
+#define FRUSTUM_SIMD_WIDTH 1
+#endif
+
+// Płaszczyzna: (a, b, c, d), punkt jest po wewnętrznej stronie gdy a*x + b*y + c*z + d >= 0
+typedef struct {
+    vec4 planes[6]; // lewa, prawa, dolna, górna, bliska, daleka
+} Frustum;
+
+// Zbiór sfer do testowania - układ SoA pod instrukcje wektorowe
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* r;
+    int count;
+    int capacity;
+} CullSet;
+
+// Wyznaczenie płaszczyzn z macierzy PV = P * V (metoda Gribba-Hartmanna)
+// linmath trzyma macierze kolumnami, więc wiersz i to (PV[0][i], PV[1][i], PV[2][i], PV[3][i])
+static inline void frustumFromMatrix(Frustum* frustum, mat4x4 const PV) {
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 4; k++) {
+            frustum->planes[i * 2 + 0][k] = PV[k][3] + PV[k][i];
+            frustum->planes[i * 2 + 1][k] = PV[k][3] - PV[k][i];
+        }
+    }
+    // Normalizacja - odległość od płaszczyzny porównujemy z promieniem sfery
+    for (int p = 0; p < 6; p++) {
+        float* plane = frustum->planes[p];
+        float len = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (len > 0.0f) {
+            for (int k = 0; k < 4; k++)
+                plane[k] /= len;
+        }
+    }
+}
+
+// Test pojedynczej sfery
+static inline int frustumTestSphere(const Frustum* frustum, vec3 const center, float radius) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = frustum->planes[p];
+        if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+            return 0;
+    }
+    return 1;
+}
+
+// Test prostopadłościanu AABB - sprawdzamy wierzchołek najdalej w kierunku normalnej
+static inline int frustumTestBox(const Frustum* frustum, vec3 const boxMin, vec3 const boxMax) {
+    for (int p = 0; p < 6; p++) {
+        const float* plane = frustum->planes[p];
+        float x = plane[0] >= 0.0f ? boxMax[0] : boxMin[0];
+        float y = plane[1] >= 0.0f ? boxMax[1] : boxMin[1];
+        float z = plane[2] >= 0.0f ? boxMax[2] : boxMin[2];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            return 0;
+    }
+    return 1;
+}
+
+// Prostopadłościan otaczający zbiór wierzchołków (stride w bajtach między kolejnymi pozycjami)
+static inline void computeBoundingBox(vec3 boxMin, vec3 boxMax, const void* positions, int count, size_t stride) {
+    const unsigned char* data = (const unsigned char*)positions;
+    for (int k = 0; k < 3; k++) {
+        boxMin[k] = count > 0 ? INFINITY : 0.0f;
+        boxMax[k] = count > 0 ? -INFINITY : 0.0f;
+    }
+    for (int i = 0; i < count; i++) {
+        const float* p = (const float*)(data + stride * i);
+        for (int k = 0; k < 3; k++) {
+            if (p[k] < boxMin[k]) boxMin[k] = p[k];
+            if (p[k] > boxMax[k]) boxMax[k] = p[k];
+        }
+    }
+}
+
+// Sfera otaczająca: środek AABB i największa odległość wierzchołka od niego
+static inline void computeBoundingSphere(vec3 center, float* radius, const void* positions, int count, size_t stride) {
+    const unsigned char* data = (const unsigned char*)positions;
+    vec3 boxMin, boxMax;
+    computeBoundingBox(boxMin, boxMax, positions, count, stride);
+    for (int k = 0; k < 3; k++)
+        center[k] = 0.5f * (boxMin[k] + boxMax[k]);
+
+    float maxDist2 = 0.0f;
+    for (int i = 0; i < count; i++) {
+        const float* p = (const float*)(data + stride * i);
+        float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+        float d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > maxDist2) maxDist2 = d2;
+    }
+    *radius = sqrtf(maxDist2);
+}
+
+static inline void cullSetInit(CullSet* set) {
+    memset(set, 0, sizeof(*set));
+}
+
+static inline void cullSetFree(CullSet* set) {
+    free(set->x);
+    free(set->y);
+    free(set->z);
+    free(set->r);
+    memset(set, 0, sizeof(*set));
+}
+
+// Zmiana liczby sfer; zwraca 0 gdy zabrakło pamięci
+static inline int cullSetResize(CullSet* set, int count) {
+    if (count > set->capacity) {
+        float* x = (float*)realloc(set->x, sizeof(float) * count);
+        if (x) set->x = x;
+        float* y = (float*)realloc(set->y, sizeof(float) * count);
+        if (y) set->y = y;
+        float* z = (float*)realloc(set->z, sizeof(float) * count);
+        if (z) set->z = z;
+        float* r = (float*)realloc(set->r, sizeof(float) * count);
+        if (r) set->r = r;
+        if (!x || !y || !z || !r)
+            return 0;
+        set->capacity = count;
+    }
+    set->count = count;
+    return 1;
+}
+
+static inline void cullSetSphere(CullSet* set, int i, vec3 const center, float radius) {
+    set->x[i] = center[0];
+    set->y[i] = center[1];
+    set->z[i] = center[2];
+    set->r[i] = radius;
+}
+
+// Test wszystkich sfer zbioru; indeksy widocznych trafiają do visibleIndices
+// (musi pomieścić set->count elementów). Zwraca liczbę widocznych.
+static inline int frustumCullSpheres(const Frustum* frustum, const CullSet* set, int* visibleIndices) {
+    int visible = 0;
+    int i = 0;
+
+#if FRUSTUM_SIMD_WIDTH == 8
+    __m256 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm256_set1_ps(frustum->planes[p][0]);
+        pb[p] = _mm256_set1_ps(frustum->planes[p][1]);
+        pc[p] = _mm256_set1_ps(frustum->planes[p][2]);
+        pd[p] = _mm256_set1_ps(frustum->planes[p][3]);
+    }
+    for (; i + 8 <= set->count; i += 8) {
+        __m256 x = _mm256_loadu_ps(set->x + i);
+        __m256 y = _mm256_loadu_ps(set->y + i);
+        __m256 z = _mm256_loadu_ps(set->z + i);
+        __m256 r = _mm256_loadu_ps(set->r + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(pa[p], x), _mm256_mul_ps(pb[p], y)),
+                                        _mm256_add_ps(_mm256_mul_ps(pc[p], z), _mm256_add_ps(pd[p], r)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        for (int bit = 0; mask && bit < 8; bit++) {
+            if (mask & (1 << bit))
+                visibleIndices[visible++] = i + bit;
+        }
+    }
+#elif FRUSTUM_SIMD_WIDTH == 4
+    __m128 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm_set1_ps(frustum->planes[p][0]);
+        pb[p] = _mm_set1_ps(frustum->planes[p][1]);
+        pc[p] = _mm_set1_ps(frustum->planes[p][2]);
+        pd[p] = _mm_set1_ps(frustum->planes[p][3]);
+    }
+    for (; i + 4 <= set->count; i += 4) {
+        __m128 x = _mm_loadu_ps(set->x + i);
+        __m128 y = _mm_loadu_ps(set->y + i);
+        __m128 z = _mm_loadu_ps(set->z + i);
+        __m128 r = _mm_loadu_ps(set->r + i);
+        __m128 inside = _mm_cmpeq_ps(x, x); // same jedynki (pozycje nie są NaN)
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa[p], x), _mm_mul_ps(pb[p], y)),
+                                     _mm_add_ps(_mm_mul_ps(pc[p], z), _mm_add_ps(pd[p], r)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(inside);
+        if (mask & 1) visibleIndices[visible++] = i;
+        if (mask & 2) visibleIndices[visible++] = i + 1;
+        if (mask & 4) visibleIndices[visible++] = i + 2;
+        if (mask & 8) visibleIndices[visible++] = i + 3;
+    }
+#endif
+
+    // Reszta (lub całość bez SIMD) sprawdzana pojedynczo
+    for (; i < set->count; i++) {
+        vec3 center = { set->x[i], set->y[i], set->z[i] };
+        if (frustumTestSphere(frustum, center, set->r[i]))
+            visibleIndices[visible++] = i;
+    }
+    return visible;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+// Pomiar czasu GPU dla stref (przebiegi renderowania, partie materiałów).
+// Początek i koniec strefy to znaczniki GL_TIMESTAMP (glQueryCounter), więc strefy mogą się
+// zagnieżdżać. Zapytania są w GPU_TIMER_FRAMES kompletach - wyniki klatki odczytujemy dopiero
+// gdy jej komplet ma być użyty ponownie, a jeśli GPU jeszcze nie skończyło, klatka jest
+// pomijana zamiast czekać. Średnie kroczące z ostatnich GPU_TIMER_WINDOW klatek i pełna
+// historia do zapisu w CSV. Wymaga wcześniejszego dołączenia glad.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GPU_TIMER_FRAMES 3          // komplety zapytań w locie
+#define GPU_TIMER_MAX_MARKS 64      // znaczniki czasu na klatkę
+#define GPU_TIMER_MAX_ZONES 16
+#define GPU_TIMER_WINDOW 60         // klatki do średniej kroczącej
+
+typedef struct {
+    int zone;
+    int beginMark;
+    int endMark;
+} GpuTimerInterval;
+
+typedef struct {
+    GLuint queries[GPU_TIMER_MAX_MARKS];
+    GpuTimerInterval intervals[GPU_TIMER_MAX_MARKS / 2];
+    int numMarks;
+    int numIntervals;
+    int frameIndex;                 // numer klatki, której dotyczą zapytania (-1 = pusty)
+} GpuTimerFrame;
+
+typedef struct {
+    int enabled;                    // 0 gdy brak GL_TIMESTAMP
+    const char* const* zoneNames;
+    int numZones;
+    GpuTimerFrame frames[GPU_TIMER_FRAMES];
+    int current;                    // komplet bieżącej klatki
+    int frameIndex;
+    int openMark[GPU_TIMER_MAX_ZONES];          // znacznik początku otwartej strefy (-1 = zamknięta)
+    float window[GPU_TIMER_MAX_ZONES][GPU_TIMER_WINDOW];
+    int windowCount;
+    int windowPos;
+    float* history;                 // numZones wartości na odczytaną klatkę
+    int* historyFrames;             // numery tych klatek
+    int historyCount;
+    int historyCapacity;
+    int droppedFrames;              // klatki pominięte, bo wynik nie był gotowy
+} GpuTimer;
+
+static inline void gpuTimerInit(GpuTimer* timer, const char* const* zoneNames, int numZones) {
+    memset(timer, 0, sizeof(*timer));
+    timer->zoneNames = zoneNames;
+    timer->numZones = numZones < GPU_TIMER_MAX_ZONES ? numZones : GPU_TIMER_MAX_ZONES;
+    for (int z = 0; z < GPU_TIMER_MAX_ZONES; z++)
+        timer->openMark[z] = -1;
+    timer->enabled = GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_timer_query;
+    if (!timer->enabled) {
+        fprintf(stderr, "Brak GL_TIMESTAMP - czasy GPU nie będą mierzone\n");
+        return;
+    }
+    for (int f = 0; f < GPU_TIMER_FRAMES; f++) {
+        glGenQueries(GPU_TIMER_MAX_MARKS, timer->frames[f].queries);
+        timer->frames[f].frameIndex = -1;
+    }
+}
+
+static inline void gpuTimerFree(GpuTimer* timer) {
+    if (timer->enabled) {
+        for (int f = 0; f < GPU_TIMER_FRAMES; f++)
+            glDeleteQueries(GPU_TIMER_MAX_MARKS, timer->frames[f].queries);
+    }
+    free(timer->history);
+    free(timer->historyFrames);
+    timer->history = NULL;
+    timer->historyFrames = NULL;
+    timer->enabled = 0;
+}
+
+// Odczyt kompletu sprzed GPU_TIMER_FRAMES klatek - bez blokowania
+static inline void gpuTimerCollect(GpuTimer* timer, GpuTimerFrame* frame) {
+    if (frame->frameIndex < 0 || frame->numMarks == 0)
+        return;
+    GLint available = 0;
+    glGetQueryObjectiv(frame->queries[frame->numMarks - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        timer->droppedFrames++;
+        return;
+    }
+
+    GLuint64 stamps[GPU_TIMER_MAX_MARKS];
+    for (int m = 0; m < frame->numMarks; m++)
+        glGetQueryObjectui64v(frame->queries[m], GL_QUERY_RESULT, &stamps[m]);
+    float zoneMs[GPU_TIMER_MAX_ZONES] = { 0.0f };
+    for (int i = 0; i < frame->numIntervals; i++) {
+        const GpuTimerInterval* interval = &frame->intervals[i];
+        zoneMs[interval->zone] += (float)((double)(stamps[interval->endMark] - stamps[interval->beginMark]) / 1.0e6);
+    }
+
+    for (int z = 0; z < timer->numZones; z++)
+        timer->window[z][timer->windowPos] = zoneMs[z];
+    timer->windowPos = (timer->windowPos + 1) % GPU_TIMER_WINDOW;
+    if (timer->windowCount < GPU_TIMER_WINDOW)
+        timer->windowCount++;
+
+    if (timer->historyCount == timer->historyCapacity) {
+        int capacity = timer->historyCapacity ? timer->historyCapacity * 2 : 1024;
+        float* history = (float*)realloc(timer->history, sizeof(float) * capacity * timer->numZones);
+        if (history) timer->history = history;
+        int* historyFrames = (int*)realloc(timer->historyFrames, sizeof(int) * capacity);
+        if (historyFrames) timer->historyFrames = historyFrames;
+        if (!history || !historyFrames)
+            return;
+        timer->historyCapacity = capacity;
+    }
+    memcpy(timer->history + timer->historyCount * timer->numZones, zoneMs, sizeof(float) * timer->numZones);
+    timer->historyFrames[timer->historyCount++] = frame->frameIndex;
+}
+
+// Na początku klatki - przejście do następnego kompletu zapytań
+static inline void gpuTimerBeginFrame(GpuTimer* timer) {
+    if (!timer->enabled)
+        return;
+    timer->current = (timer->current + 1) % GPU_TIMER_FRAMES;
+    GpuTimerFrame* frame = &timer->frames[timer->current];
+    gpuTimerCollect(timer, frame);
+    frame->numMarks = 0;
+    frame->numIntervals = 0;
+    frame->frameIndex = timer->frameIndex++;
+    for (int z = 0; z < GPU_TIMER_MAX_ZONES; z++)
+        timer->openMark[z] = -1;
+}
+
+static inline void gpuTimerBegin(GpuTimer* timer, int zone) {
+    if (!timer->enabled || zone < 0 || zone >= timer->numZones)
+        return;
+    GpuTimerFrame* frame = &timer->frames[timer->current];
+    if (frame->numMarks >= GPU_TIMER_MAX_MARKS - 1)
+        return;
+    glQueryCounter(frame->queries[frame->numMarks], GL_TIMESTAMP);
+    timer->openMark[zone] = frame->numMarks++;
+}
+
+static inline void gpuTimerEnd(GpuTimer* timer, int zone) {
+    if (!timer->enabled || zone < 0 || zone >= timer->numZones || timer->openMark[zone] < 0)
+        return;
+    GpuTimerFrame* frame = &timer->frames[timer->current];
+    if (frame->numMarks >= GPU_TIMER_MAX_MARKS) {
+        timer->openMark[zone] = -1;
+        return;
+    }
+    glQueryCounter(frame->queries[frame->numMarks], GL_TIMESTAMP);
+    GpuTimerInterval* interval = &frame->intervals[frame->numIntervals++];
+    interval->zone = zone;
+    interval->beginMark = timer->openMark[zone];
+    interval->endMark = frame->numMarks++;
+    timer->openMark[zone] = -1;
+}
+
+// Średnia krocząca czasu strefy w ms (0 gdy brak pomiarów)
+static inline float gpuTimerAverage(const GpuTimer* timer, int zone) {
+    if (timer->windowCount == 0)
+        return 0.0f;
+    float sum = 0.0f;
+    for (int i = 0; i < timer->windowCount; i++)
+        sum += timer->window[zone][i];
+    return sum / timer->windowCount;
+}
+
+// Historia wszystkich odczytanych klatek: kolumna na strefę, czasy w ms
+static inline int gpuTimerWriteCsv(const GpuTimer* timer, const char* fileName) {
+    FILE* file = fopen(fileName, "w");
+    if (!file) {
+        fprintf(stderr, "Nie można zapisać %s\n", fileName);
+        return 0;
+    }
+    fprintf(file, "frame");
+    for (int z = 0; z < timer->numZones; z++)
+        fprintf(file, ",%s", timer->zoneNames[z]);
+    fprintf(file, "\n");
+    for (int i = 0; i < timer->historyCount; i++) {
+        fprintf(file, "%d", timer->historyFrames[i]);
+        for (int z = 0; z < timer->numZones; z++)
+            fprintf(file, ",%.4f", timer->history[i * timer->numZones + z]);
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    printf("Zapisano czasy GPU %d klatek do %s (pominięte: %d)\n", timer->historyCount, fileName, timer->droppedFrames);
+    return 1;
+}
+
+#endif
@@ -15,8 +15,40 @@
 #define LINMATH_H_FUNC static inline
 #endif
 
-#define LINMATH_H_DEFINE_VEC(n) \
-typedef float vec##n[n]; \
+/* SIMD backend, selected at compile time. Define LINMATH_NO_SIMD to force
+ * the scalar loops. The *_scalar versions of mat4x4_mul, mat4x4_mul_vec4
+ * and mat4x4_invert are always available, to compare results or throughput
+ * against them (see linmathbench.h).
+ * SSE is always there on x64; AVX (/arch:AVX, -mavx) additionally lets
+ * mat4x4_mul compute two columns per instruction. AVX2 (/arch:AVX2,
+ * -mavx2 -mfma) adds nothing for 4x4 floats except FMA, which fuses the
+ * multiply-adds in mat4x4_mul and mat4x4_mul_vec4; with a single rounding
+ * per step their results differ from the scalar loops in the last bits.
+ */
+#if !defined(LINMATH_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define LINMATH_SIMD_SSE
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#define LINMATH_SIMD_AVX
+#include <immintrin.h>
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define LINMATH_SIMD_FMA
+#endif
+#endif
+#endif
+
+#define LINMATH_H_DEFINE_VEC_LEN(n) \
+LINMATH_H_FUNC float vec##n##_len(vec##n const v) \
+{ \
+	return sqrtf(vec##n##_mul_inner(v,v)); \
+} \
+LINMATH_H_FUNC void vec##n##_norm(vec##n r, vec##n const v) \
+{ \
+	float k = 1.f / vec##n##_len(v); \
+	vec##n##_scale(r, v, k); \
+}
+
+#define LINMATH_H_DEFINE_VEC_ARITH(n) \
 LINMATH_H_FUNC void vec##n##_add(vec##n r, vec##n const a, vec##n const b) \
 { \
 	int i; \
@@ -43,15 +75,6 @@ LINMATH_H_FUNC float vec##n##_mul_inner(vec##n const a, vec##n const b) \
 		p += b[i]*a[i]; \
 	return p; \
 } \
-LINMATH_H_FUNC float vec##n##_len(vec##n const v) \
-{ \
-	return sqrtf(vec##n##_mul_inner(v,v)); \
-} \
-LINMATH_H_FUNC void vec##n##_norm(vec##n r, vec##n const v) \
-{ \
-	float k = 1.f / vec##n##_len(v); \
-	vec##n##_scale(r, v, k); \
-} \
 LINMATH_H_FUNC void vec##n##_min(vec##n r, vec##n const a, vec##n const b) \
 { \
 	int i; \
@@ -71,9 +94,54 @@ LINMATH_H_FUNC void vec##n##_dup(vec##n r, vec##n const src) \
 		r[i] = src[i]; \
 }
 
+#define LINMATH_H_DEFINE_VEC(n) \
+typedef float vec##n[n]; \
+LINMATH_H_DEFINE_VEC_ARITH(n) \
+LINMATH_H_DEFINE_VEC_LEN(n)
+
 LINMATH_H_DEFINE_VEC(2)
 LINMATH_H_DEFINE_VEC(3)
+
+#ifdef LINMATH_SIMD_SSE
+/* vec4 is exactly one SSE register. Arrays are not guaranteed to be
+ * 16-byte aligned, hence the unaligned loads and stores.
+ */
+typedef float vec4[4];
+LINMATH_H_FUNC void vec4_add(vec4 r, vec4 const a, vec4 const b)
+{
+	_mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+LINMATH_H_FUNC void vec4_sub(vec4 r, vec4 const a, vec4 const b)
+{
+	_mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+LINMATH_H_FUNC void vec4_scale(vec4 r, vec4 const v, float const s)
+{
+	_mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(v), _mm_set1_ps(s)));
+}
+LINMATH_H_FUNC float vec4_mul_inner(vec4 const a, vec4 const b)
+{
+	__m128 p = _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+	p = _mm_add_ps(p, _mm_movehl_ps(p, p));
+	p = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(p);
+}
+LINMATH_H_FUNC void vec4_min(vec4 r, vec4 const a, vec4 const b)
+{
+	_mm_storeu_ps(r, _mm_min_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+LINMATH_H_FUNC void vec4_max(vec4 r, vec4 const a, vec4 const b)
+{
+	_mm_storeu_ps(r, _mm_max_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+LINMATH_H_FUNC void vec4_dup(vec4 r, vec4 const src)
+{
+	_mm_storeu_ps(r, _mm_loadu_ps(src));
+}
+LINMATH_H_DEFINE_VEC_LEN(4)
+#else
 LINMATH_H_DEFINE_VEC(4)
+#endif
 
 LINMATH_H_FUNC void vec3_mul_cross(vec3 r, vec3 const a, vec3 const b)
 {
@@ -166,7 +234,7 @@ LINMATH_H_FUNC void mat4x4_scale_aniso(mat4x4 M, mat4x4 const a, float x, float
 	vec4_scale(M[2], a[2], z);
 	vec4_dup(M[3], a[3]);
 }
-LINMATH_H_FUNC void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b)
+LINMATH_H_FUNC void mat4x4_mul_scalar(mat4x4 M, mat4x4 const a, mat4x4 const b)
 {
 	mat4x4 temp;
 	int k, r, c;
@@ -177,7 +245,59 @@ LINMATH_H_FUNC void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b)
 	}
 	mat4x4_dup(M, temp);
 }
-LINMATH_H_FUNC void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v)
+LINMATH_H_FUNC void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b)
+{
+#if defined(LINMATH_SIMD_AVX)
+	/* Columns c and c+1 of the result in one register: each half is
+	 * a[0]*b[c][0] + a[1]*b[c][1] + ... for its own column of b.
+	 */
+	__m256 a0 = _mm256_broadcast_ps((__m128 const*)a[0]);
+	__m256 a1 = _mm256_broadcast_ps((__m128 const*)a[1]);
+	__m256 a2 = _mm256_broadcast_ps((__m128 const*)a[2]);
+	__m256 a3 = _mm256_broadcast_ps((__m128 const*)a[3]);
+	__m256 b01 = _mm256_loadu_ps(b[0]);
+	__m256 b23 = _mm256_loadu_ps(b[2]);
+	__m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+	__m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+#if defined(LINMATH_SIMD_FMA)
+	r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+	r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+	r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+	r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+	r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+	r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+#else
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+	r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+	r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xFF)));
+#endif
+	/* Everything is read before the first store, so M may alias a or b */
+	_mm256_storeu_ps(M[0], r01);
+	_mm256_storeu_ps(M[2], r23);
+#elif defined(LINMATH_SIMD_SSE)
+	__m128 a0 = _mm_loadu_ps(a[0]);
+	__m128 a1 = _mm_loadu_ps(a[1]);
+	__m128 a2 = _mm_loadu_ps(a[2]);
+	__m128 a3 = _mm_loadu_ps(a[3]);
+	__m128 r[4];
+	int c;
+	for(c=0; c<4; ++c) {
+		__m128 bc = _mm_loadu_ps(b[c]);
+		__m128 t = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+		t = _mm_add_ps(t, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+		t = _mm_add_ps(t, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+		r[c] = _mm_add_ps(t, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+	}
+	for(c=0; c<4; ++c)
+		_mm_storeu_ps(M[c], r[c]);
+#else
+	mat4x4_mul_scalar(M, a, b);
+#endif
+}
+LINMATH_H_FUNC void mat4x4_mul_vec4_scalar(vec4 r, mat4x4 const M, vec4 const v)
 {
 	int i, j;
 	for(j=0; j<4; ++j) {
@@ -186,6 +306,25 @@ LINMATH_H_FUNC void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v)
 			r[j] += M[i][j] * v[i];
 	}
 }
+LINMATH_H_FUNC void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v)
+{
+#ifdef LINMATH_SIMD_SSE
+	__m128 x = _mm_loadu_ps(v);
+	__m128 t = _mm_mul_ps(_mm_loadu_ps(M[0]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0)));
+#ifdef LINMATH_SIMD_FMA
+	t = _mm_fmadd_ps(_mm_loadu_ps(M[1]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)), t);
+	t = _mm_fmadd_ps(_mm_loadu_ps(M[2]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2)), t);
+	t = _mm_fmadd_ps(_mm_loadu_ps(M[3]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3)), t);
+#else
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(M[1]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(M[2]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2))));
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(M[3]), _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3))));
+#endif
+	_mm_storeu_ps(r, t);
+#else
+	mat4x4_mul_vec4_scalar(r, M, v);
+#endif
+}
 LINMATH_H_FUNC void mat4x4_translate(mat4x4 T, float x, float y, float z)
 {
 	mat4x4_identity(T);
@@ -279,7 +418,7 @@ LINMATH_H_FUNC void mat4x4_rotate_Z(mat4x4 Q, mat4x4 const M, float angle)
 	};
 	mat4x4_mul(Q, M, R);
 }
-LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
+LINMATH_H_FUNC void mat4x4_invert_scalar(mat4x4 T, mat4x4 const M)
 {
 	float s[6];
 	float c[6];
@@ -320,6 +459,83 @@ LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
 	T[3][2] = (-M[3][0] * s[3] + M[3][1] * s[1] - M[3][2] * s[0]) * idet;
 	T[3][3] = ( M[2][0] * s[3] - M[2][1] * s[1] + M[2][2] * s[0]) * idet;
 }
+#ifdef LINMATH_SIMD_SSE
+/* 2x2 blocks packed as (m00, m01, m10, m11) */
+#define LINMATH_H_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+#define LINMATH_H_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+LINMATH_H_FUNC __m128 mat2x2_mul_sse(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, LINMATH_H_SWIZZLE(b, 0, 3, 0, 3)),
+	                  _mm_mul_ps(LINMATH_H_SWIZZLE(a, 1, 0, 3, 2), LINMATH_H_SWIZZLE(b, 2, 1, 2, 1)));
+}
+/* adj(a) * b */
+LINMATH_H_FUNC __m128 mat2x2_adj_mul_sse(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(LINMATH_H_SWIZZLE(a, 3, 3, 0, 0), b),
+	                  _mm_mul_ps(LINMATH_H_SWIZZLE(a, 1, 1, 2, 2), LINMATH_H_SWIZZLE(b, 2, 3, 0, 1)));
+}
+/* a * adj(b) */
+LINMATH_H_FUNC __m128 mat2x2_mul_adj_sse(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, LINMATH_H_SWIZZLE(b, 3, 0, 3, 0)),
+	                  _mm_mul_ps(LINMATH_H_SWIZZLE(a, 1, 0, 3, 2), LINMATH_H_SWIZZLE(b, 2, 1, 2, 1)));
+}
+#endif
+LINMATH_H_FUNC void mat4x4_invert(mat4x4 T, mat4x4 const M)
+{
+#ifdef LINMATH_SIMD_SSE
+	/* Block-wise inverse: M = | A B |, inverse is 1/det(M) * | X Y |
+	 *                         | C D |                        | Z W |
+	 * (written for rows; since inv(M^T) = inv(M)^T it works for columns too)
+	 */
+	__m128 m0 = _mm_loadu_ps(M[0]);
+	__m128 m1 = _mm_loadu_ps(M[1]);
+	__m128 m2 = _mm_loadu_ps(M[2]);
+	__m128 m3 = _mm_loadu_ps(M[3]);
+	__m128 A = _mm_movelh_ps(m0, m1);
+	__m128 B = _mm_movehl_ps(m1, m0);
+	__m128 C = _mm_movelh_ps(m2, m3);
+	__m128 D = _mm_movehl_ps(m3, m2);
+
+	/* (det A, det B, det C, det D) */
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(LINMATH_H_SHUFFLE(m0, m2, 0, 2, 0, 2), LINMATH_H_SHUFFLE(m1, m3, 1, 3, 1, 3)),
+		_mm_mul_ps(LINMATH_H_SHUFFLE(m0, m2, 1, 3, 1, 3), LINMATH_H_SHUFFLE(m1, m3, 0, 2, 0, 2)));
+	__m128 detA = LINMATH_H_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = LINMATH_H_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = LINMATH_H_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = LINMATH_H_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	__m128 D_C = mat2x2_adj_mul_sse(D, C);
+	__m128 A_B = mat2x2_adj_mul_sse(A, B);
+	__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2x2_mul_sse(B, D_C));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2x2_mul_sse(C, A_B));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2x2_mul_adj_sse(D, A_B));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2x2_mul_adj_sse(A, D_C));
+
+	/* det M = det A * det D + det B * det C - tr(adj(A)B * adj(D)C) */
+	__m128 tr = _mm_mul_ps(A_B, LINMATH_H_SWIZZLE(D_C, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+	tr = _mm_add_ps(tr, LINMATH_H_SWIZZLE(tr, 1, 1, 1, 1));
+	tr = LINMATH_H_SWIZZLE(tr, 0, 0, 0, 0);
+	__m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+	/* Assumes it is invertible */
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+	X = _mm_mul_ps(X, rDetM);
+	Y = _mm_mul_ps(Y, rDetM);
+	Z = _mm_mul_ps(Z, rDetM);
+	W = _mm_mul_ps(W, rDetM);
+
+	/* The blocks above are adjugates; the shuffles transpose them back while storing */
+	_mm_storeu_ps(T[0], LINMATH_H_SHUFFLE(X, Y, 3, 1, 3, 1));
+	_mm_storeu_ps(T[1], LINMATH_H_SHUFFLE(X, Y, 2, 0, 2, 0));
+	_mm_storeu_ps(T[2], LINMATH_H_SHUFFLE(Z, W, 3, 1, 3, 1));
+	_mm_storeu_ps(T[3], LINMATH_H_SHUFFLE(Z, W, 2, 0, 2, 0));
+#else
+	mat4x4_invert_scalar(T, M);
+#endif
+}
 LINMATH_H_FUNC void mat4x4_orthonormalize(mat4x4 R, mat4x4 const M)
 {
 	mat4x4_dup(R, M);
@@ -603,4 +819,52 @@ LINMATH_H_FUNC void mat4x4_arcball(mat4x4 R, mat4x4 const M, vec2 const _a, vec2
 	float const angle = acos(vec3_mul_inner(a_, b_)) * s;
 	mat4x4_rotate(R, M, c_[0], c_[1], c_[2], angle);
 }
+
+/* Rigid transform: rotation followed by translation, p' = q * p + t.
+ * Composition and inversion only need quaternion products and the
+ * conjugate instead of full 4x4 multiplies and a cofactor inverse.
+ * q must be a unit quaternion.
+ */
+typedef struct {
+	quat q;
+	vec3 t;
+} rigid;
+LINMATH_H_FUNC void rigid_identity(rigid* R)
+{
+	quat_identity(R->q);
+	R->t[0] = R->t[1] = R->t[2] = 0.f;
+}
+LINMATH_H_FUNC void rigid_mul_vec3(vec3 r, rigid const* a, vec3 const v)
+{
+	vec3 p;
+	quat_mul_vec3(p, a->q, v);
+	vec3_add(r, p, a->t);
+}
+/* R = a * b, i.e. b is applied first. R may alias a or b. */
+LINMATH_H_FUNC void rigid_mul(rigid* R, rigid const* a, rigid const* b)
+{
+	quat q;
+	vec3 t;
+	quat_mul(q, a->q, b->q);
+	rigid_mul_vec3(t, a, b->t);
+	vec4_dup(R->q, q);
+	vec3_dup(R->t, t);
+}
+/* inverse(q, t) = (conj(q), -(conj(q) * t)) */
+LINMATH_H_FUNC void rigid_invert(rigid* R, rigid const* a)
+{
+	quat q;
+	vec3 t;
+	quat_conj(q, a->q);
+	quat_mul_vec3(t, q, a->t);
+	vec4_dup(R->q, q);
+	vec3_scale(R->t, t, -1.f);
+}
+LINMATH_H_FUNC void mat4x4_from_rigid(mat4x4 M, rigid const* a)
+{
+	mat4x4_from_quat(M, a->q);
+	M[3][0] = a->t[0];
+	M[3][1] = a->t[1];
+	M[3][2] = a->t[2];
+}
 #endif
@@ -7,110 +7,562 @@
 #pragma warning(disable: 4244)
 #include "linmath.h"
 #pragma warning(pop)
+#include "frustum.h"
+#include "bvh.h"
+#include "transform.h"
+#include "headless.h"
+#include "camerapath.h"
+#include "gputimer.h"
+#include "profiler.h"
+#include "overlay.h"
+#include "programcache.h"
+#include "filewatch.h"
+#include "assetfile.h"
+#include "shadersource.h"
+#include "threadpool.h"
+#include "texsynth.h"
+#include "linmathbench.h"
+#include "mipmap.h"
+#include "texcompress.h"
+#include "texstream.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <stdint.h>
 #include <time.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-// Funkcje do ładowania shaderów z plików
-// Shadery są w oddzielnych plikach zgodnie z wymaganiami
-char* loadShaderFile(const char* filename) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        fprintf(stderr, "Nie można otworzyć pliku: %s\n", filename);
-        return NULL;
+// Kontekst core profile 3.3 (argument --core) - domyślnie kontekst 2.0 jak dotychczas
+static int coreProfile = 0;
+
+// Nagłówki podmieniające "#version 110" gdy działamy w core profile.
+// Shadery zostają w GLSL 110, a makra tłumaczą attribute/varying/texture2D/gl_FragColor na GLSL 330.
+static const char* coreVertexHeader =
+    "#version 330 core\n"
+    "#define attribute in\n"
+    "#define varying out\n"
+    "#define texture2D texture\n";
+static const char* coreFragmentHeader =
+    "#version 330 core\n"
+    "#define varying in\n"
+    "#define texture2D texture\n"
+    "#define texture2DArray texture\n"
+    "out vec4 fragColor;\n"
+    "#define gl_FragColor fragColor\n";
+
+// Zlinkowane programy zapisywane na dysku między uruchomieniami (wyłączane argumentem --no-shader-cache)
+static ProgramCache shaderCache;
+
+// Pliki shaderów zmapowane do pamięci - źródła idą do glShaderSource bez kopiowania,
+// a po nim pliki są od razu odmapowywane (edytor musi móc je zapisać)
+static AssetPool assetPool;
+
+// Definicje wstrzykiwane do wszystkich shaderów (argument --shader-define), lista zakończona NULL
+#define MAX_SHADER_DEFINES 16
+static const char* shaderDefines[MAX_SHADER_DEFINES + 1];
+
+static void addShaderDefine(const char* define) {
+    int numDefines = 0;
+    while (shaderDefines[numDefines])
+        numDefines++;
+    if (numDefines < MAX_SHADER_DEFINES)
+        shaderDefines[numDefines] = define;
+}
+
+// Pliki, z których zbudowano program (główne i dołączone) - zmiana któregokolwiek go przeładowuje
+typedef struct {
+    char files[2 * SHADER_SOURCE_MAX_FILES][ASSET_PATH_MAX];
+    int count;
+} ShaderDependencies;
+
+static void addShaderDependencies(ShaderDependencies* deps, const ShaderSource* source) {
+    for (int i = 0; i < source->numFiles && deps->count < 2 * SHADER_SOURCE_MAX_FILES; i++)
+        snprintf(deps->files[deps->count++], ASSET_PATH_MAX, "%s", source->files[i]);
+}
+
+// Refleksja programu shaderowego - tablica uniformów i atrybutów budowana raz po linkowaniu,
+// żeby w pętli renderowania nie odpytywać sterownika o lokalizacje po nazwach
+enum UniformSlot {
+    U_MVP, U_M, U_V, U_LIGHT_POS, U_LIGHT_COLOR, U_VIEW_POS, U_TIME, U_TEXTURE_SAMPLER, U_TEXTURE_LAYER, U_OBJECT_COLOR,
+    U_COUNT
+};
+enum AttribSlot {
+    A_POS, A_NORMAL, A_COL, A_TEXCOORD,
+    A_COUNT
+};
+static const char* uniformSlotNames[U_COUNT] = {
+    "MVP", "M", "V", "lightPos", "lightColor", "viewPos", "time", "textureSampler", "textureLayer", "objectColor"
+};
+static const char* attribSlotNames[A_COUNT] = {
+    "vPos", "vNormal", "vCol", "vTexCoord"
+};
+
+#define MAX_PROGRAM_VARIABLES 32
+
+typedef struct {
+    char name[64];
+    GLint location;
+    GLenum type;   // np. GL_FLOAT_MAT4, GL_FLOAT_VEC3, GL_SAMPLER_2D
+    GLint size;    // liczba elementów dla tablic
+} ShaderVariable;
+
+typedef struct {
+    GLuint id;
+    ShaderVariable uniforms[MAX_PROGRAM_VARIABLES];
+    int numUniforms;
+    ShaderVariable attributes[MAX_PROGRAM_VARIABLES];
+    int numAttributes;
+    GLint uniformLoc[U_COUNT]; // -1 gdy program nie używa danego uniformu
+    GLint attribLoc[A_COUNT];
+    // Budowa zlecona sterownikowi, a jeszcze nie sprawdzona (refleksja dopiero po zakończeniu)
+    int pending;
+    GLuint vertShader, fragShader;
+    const char* vertFile;
+    const char* fragFile;
+    uint64_t cacheKey;
+} ShaderProgram;
+
+// Wyszukanie zmiennej w tablicy refleksji (bez wywołań OpenGL)
+GLint findShaderVariable(const ShaderVariable* vars, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(vars[i].name, name) == 0)
+            return vars[i].location;
     }
+    return -1;
+}
+
+// Budowa tablicy refleksji dla zlinkowanego programu
+void reflectShaderProgram(ShaderProgram* sp, GLuint program) {
+    memset(sp, 0, sizeof(*sp));
+    sp->id = program;
     
-    // Sprawdzamy rozmiar pliku
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    // Alokujemy pamięć i wczytujemy zawartość
-    char* buffer = (char*)malloc(length + 1);
-    if (!buffer) {
-        fclose(file);
-        return NULL;
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count && sp->numUniforms < MAX_PROGRAM_VARIABLES; i++) {
+        ShaderVariable* var = &sp->uniforms[sp->numUniforms];
+        glGetActiveUniform(program, (GLuint)i, sizeof(var->name), NULL, &var->size, &var->type, var->name);
+        // Tablice są zgłaszane jako "nazwa[0]" - zapisujemy samą nazwę
+        char* bracket = strchr(var->name, '[');
+        if (bracket) *bracket = '\0';
+        var->location = glGetUniformLocation(program, var->name);
+        if (var->location >= 0) sp->numUniforms++;
     }
     
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0'; // Dodajemy null terminator
-    fclose(file);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count && sp->numAttributes < MAX_PROGRAM_VARIABLES; i++) {
+        ShaderVariable* var = &sp->attributes[sp->numAttributes];
+        glGetActiveAttrib(program, (GLuint)i, sizeof(var->name), NULL, &var->size, &var->type, var->name);
+        var->location = glGetAttribLocation(program, var->name);
+        if (var->location >= 0) sp->numAttributes++; // pomijamy wbudowane (gl_*)
+    }
     
-    return buffer;
+    for (int i = 0; i < U_COUNT; i++)
+        sp->uniformLoc[i] = findShaderVariable(sp->uniforms, sp->numUniforms, uniformSlotNames[i]);
+    for (int i = 0; i < A_COUNT; i++)
+        sp->attribLoc[i] = findShaderVariable(sp->attributes, sp->numAttributes, attribSlotNames[i]);
 }
 
-// Kompilacja shadera z pliku
-GLuint loadShader(GLenum type, const char* filename) {
-    char* source = loadShaderFile(filename);
-    if (!source) {
-        return 0;
+// Budowa programów bez czekania: glCompileShader i glLinkProgram tylko zlecają pracę, a status
+// sprawdzamy dopiero przy pierwszym użyciu programu albo gdy sterownik zgłosi koniec
+// (GL_KHR_parallel_shader_compile - kompilacja na wątkach sterownika, w tle pracy CPU).
+static int parallelShaderCompile = 0;
+
+void initShaderCompiler(void) {
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // liczbę wątków wybiera sterownik
+        parallelShaderCompile = 1;
+    } else if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        parallelShaderCompile = 1;
     }
-    
-    // Tworzymy shader i kompilujemy
+}
+
+// Bez rozszerzenia zapytanie o GL_COMPILE_STATUS czeka na sterownik, więc przeładowania budowane są
+// na osobnym wątku z niewidocznym oknem, którego kontekst dzieli obiekty z głównym. Wątek główny
+// tylko sprawdza flagę done i odbiera gotowy program.
+#define SHADER_BUILDER_MAX_JOBS 8
+
+typedef struct {
+    char* vertSource;       // źródła złożone w jeden bufor - pliki są odmapowywane zaraz po zleceniu
+    char* fragSource;
+    const char* vertFile;
+    const char* fragFile;
+    uint64_t cacheKey;
+    GLuint program;         // wynik: 0 przy błędzie kompilacji lub linkowania
+    std::atomic<int> done;
+    int queued;             // zlecone, a wynik jeszcze nie odebrany przez wątek główny
+} ShaderBuildJob;
+
+typedef struct {
+    GLFWwindow* context;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    ShaderBuildJob* queue[SHADER_BUILDER_MAX_JOBS];
+    int count;
+    int quit;
+} ShaderBuilder;
+
+// NULL - programy budowane w wątku głównym; wskazuje na obiekt z main (exit() nie niszczy wątku)
+static ShaderBuilder* shaderBuilder = NULL;
+
+static GLuint submitShader(GLenum type, const char* const* parts, const GLint* lengths, int numParts) {
     GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, (const char**)&source, NULL);
+    glShaderSource(shader, numParts, parts, lengths);
     glCompileShader(shader);
+    return shader;
+}
+
+// Fragmenty źródła w jednym buforze zakończonym NUL (dla wątku budowy)
+static char* joinShaderSource(const ShaderSource* src) {
+    size_t size = 1;
+    for (int i = 0; i < src->numParts; i++)
+        size += (size_t)src->lengths[i];
+    char* text = (char*)malloc(size);
+    if (!text)
+        return NULL;
+    size_t offset = 0;
+    for (int i = 0; i < src->numParts; i++) {
+        memcpy(text + offset, src->parts[i], (size_t)src->lengths[i]);
+        offset += (size_t)src->lengths[i];
+    }
+    text[offset] = '\0';
+    return text;
+}
+
+static GLuint buildShaderJob(const ShaderBuildJob* job);
+
+// Przy pełnej kolejce (więcej zleceń naraz niż SHADER_BUILDER_MAX_JOBS) program budowany jest
+// od razu w wątku głównym - z przycięciem klatki, ale bez wyjścia poza tablicę
+static void shaderBuilderSubmit(ShaderBuilder* builder, ShaderBuildJob* job) {
+    {
+        std::lock_guard<std::mutex> lock(builder->mutex);
+        if (builder->count < SHADER_BUILDER_MAX_JOBS) {
+            builder->queue[builder->count++] = job;
+            job = NULL;
+        }
+    }
+    if (!job) {
+        builder->wake.notify_one();
+        return;
+    }
+    fprintf(stderr, "Kolejka budowy shaderów pełna - %s / %s budowane w wątku głównym\n", job->vertFile, job->fragFile);
+    job->program = buildShaderJob(job);
+    job->done.store(1);
+}
+
+// Zlecenie budowy programu; program z pamięci podręcznej jest gotowy od razu.
+// Z job (nie NULL, tylko przy shaderBuilder) kompilacja idzie na wątek, a sp zostaje pusty do collectShaderBuild.
+// Zwraca 0 gdy nie da się wczytać plików.
+int submitShaderProgram(ShaderProgram* sp, const char* vertFile, const char* fragFile, ShaderDependencies* deps,
+                        ShaderBuildJob* job) {
+    // Źródła po rozwinięciu #include i rozstrzygnięciu #ifdef - tylko w wątku głównym, więc statyczne
+    static ShaderSource vert, frag;
+    // W core profile linia #version z pliku zastępowana jest nagłówkiem GLSL 330
+    int vertOk = shaderSourceBuild(&vert, &assetPool, vertFile, coreProfile ? coreVertexHeader : NULL, shaderDefines);
+    int fragOk = shaderSourceBuild(&frag, &assetPool, fragFile, coreProfile ? coreFragmentHeader : NULL, shaderDefines);
+    if (deps) {
+        deps->count = 0;
+        addShaderDependencies(deps, &vert);
+        addShaderDependencies(deps, &frag);
+    }
+    if (!vertOk || !fragOk) {
+        assetPoolRelease(&assetPool);
+        return 0;
+    }
+    // Klucz z rozwiniętych źródeł - każda permutacja ma własny wpis w pamięci podręcznej
+    uint64_t cacheKey = programCacheKey(&shaderCache, vert.parts, vert.lengths, vert.numParts,
+                                        frag.parts, frag.lengths, frag.numParts);
+    GLuint program = programCacheLoad(&shaderCache, cacheKey);
+    if (program) {
+        assetPoolRelease(&assetPool);
+        reflectShaderProgram(sp, program);
+        return 1;
+    }
     
-    // Sprawdzamy czy kompilacja się powiodła
+    memset(sp, 0, sizeof(*sp));
+    if (job) {
+        job->vertSource = joinShaderSource(&vert);
+        job->fragSource = joinShaderSource(&frag);
+        assetPoolRelease(&assetPool);
+        if (!job->vertSource || !job->fragSource) {
+            fprintf(stderr, "Brak pamięci na źródła %s / %s\n", vertFile, fragFile);
+            free(job->vertSource);
+            free(job->fragSource);
+            return 0;
+        }
+        job->vertFile = vertFile;
+        job->fragFile = fragFile;
+        job->cacheKey = cacheKey;
+        job->program = 0;
+        job->done.store(0);
+        job->queued = 1;
+        shaderBuilderSubmit(shaderBuilder, job);
+        return 1;
+    }
+    sp->vertShader = submitShader(GL_VERTEX_SHADER, vert.parts, vert.lengths, vert.numParts);
+    sp->fragShader = submitShader(GL_FRAGMENT_SHADER, frag.parts, frag.lengths, frag.numParts);
+    // glShaderSource skopiował źródła - fragmenty vert/frag nie są już potrzebne
+    assetPoolRelease(&assetPool);
+    
+    // Linkowanie zlecamy od razu - sterownik poczeka na kompilację bez udziału naszego wątku
+    sp->id = glCreateProgram();
+    glAttachShader(sp->id, sp->vertShader);
+    glAttachShader(sp->id, sp->fragShader);
+    programCachePrepare(&shaderCache, sp->id);
+    glLinkProgram(sp->id);
+    sp->vertFile = vertFile;
+    sp->fragFile = fragFile;
+    sp->cacheKey = cacheKey;
+    sp->pending = 1;
+    return 1;
+}
+
+static int checkShaderCompiled(GLuint shader, const char* filename) {
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
         fprintf(stderr, "Błąd kompilacji shadera %s:\n%s\n", filename, infoLog);
-        free(source);
-        glDeleteShader(shader);
-        return 0;
     }
-    
-    free(source);
-    return shader;
+    return success;
 }
 
-// Tworzenie programu shaderowego z vertex i fragment shadera
-GLuint createShaderProgram(const char* vertFile, const char* fragFile) {
-    GLuint vertShader = loadShader(GL_VERTEX_SHADER, vertFile);
-    GLuint fragShader = loadShader(GL_FRAGMENT_SHADER, fragFile);
-    
-    if (!vertShader || !fragShader) {
-        if (vertShader) glDeleteShader(vertShader);
-        if (fragShader) glDeleteShader(fragShader);
-        return 0;
-    }
-    
-    // Łączymy shadery w program
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertShader);
-    glAttachShader(program, fragShader);
-    glLinkProgram(program);
-    
-    // Sprawdzamy czy linkowanie się powiodło
+static int checkProgramLinked(GLuint program) {
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
         char infoLog[512];
         glGetProgramInfoLog(program, 512, NULL, infoLog);
         fprintf(stderr, "Błąd linkowania programu:\n%s\n", infoLog);
-        glDeleteProgram(program);
-        glDeleteShader(vertShader);
-        glDeleteShader(fragShader);
-        return 0;
     }
+    return success;
+}
+
+// Sprawdzenie wyniku budowy (czeka, jeśli sterownik jeszcze pracuje), refleksja i zapis do pamięci podręcznej.
+// Zwraca 0 przy błędzie kompilacji lub linkowania.
+int finishShaderProgram(ShaderProgram* sp) {
+    if (!sp->pending)
+        return sp->id != 0;
+    GLuint program = sp->id;
+    GLuint vertShader = sp->vertShader, fragShader = sp->fragShader;
+    int compiled = checkShaderCompiled(vertShader, sp->vertFile);
+    compiled = checkShaderCompiled(fragShader, sp->fragFile) && compiled;
     
+    int success = compiled && checkProgramLinked(program);
     // Usuwamy shadery bo są już w programie
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
+    if (!success) {
+        glDeleteProgram(program);
+        memset(sp, 0, sizeof(*sp));
+        return 0;
+    }
+    programCacheStore(&shaderCache, sp->cacheKey, program);
+    reflectShaderProgram(sp, program);
+    return 1;
+}
+
+// Bez czekania: 1 gdy program jest gotowy (wtedy też kończy budowę), 0 gdy sterownik jeszcze pracuje,
+// -1 przy błędzie. Bez rozszerzenia nie da się zapytać o postęp - program kończony jest dopiero przy
+// pierwszym użyciu.
+int pollShaderProgram(ShaderProgram* sp) {
+    if (!sp->pending)
+        return 1;
+    if (!parallelShaderCompile)
+        return 0;
+    GLint done = 0;
+    glGetProgramiv(sp->id, GL_COMPLETION_STATUS_KHR, &done);
+    if (!done)
+        return 0;
+    return finishShaderProgram(sp) ? 1 : -1;
+}
+
+// Pierwsze użycie programu - od tej chwili potrzebne są lokalizacje z refleksji
+void requireShaderProgram(ShaderProgram* sp) {
+    if (sp->pending && !finishShaderProgram(sp)) {
+        fprintf(stderr, "Błąd ładowania shaderów!\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Porzucenie programu razem z niedokończoną budową
+void discardShaderProgram(ShaderProgram* sp) {
+    if (sp->pending) {
+        glDeleteShader(sp->vertShader);
+        glDeleteShader(sp->fragShader);
+    }
+    if (sp->id)
+        glDeleteProgram(sp->id);
+    memset(sp, 0, sizeof(*sp));
+}
+
+// Cała budowa w kontekście wątku - tu można czekać na sterownik, klatki rysuje wątek główny
+static GLuint buildShaderJob(const ShaderBuildJob* job) {
+    GLuint vertShader = submitShader(GL_VERTEX_SHADER, &job->vertSource, NULL, 1);
+    GLuint fragShader = submitShader(GL_FRAGMENT_SHADER, &job->fragSource, NULL, 1);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    programCachePrepare(&shaderCache, program);
+    glLinkProgram(program);
+    int compiled = checkShaderCompiled(vertShader, job->vertFile);
+    compiled = checkShaderCompiled(fragShader, job->fragFile) && compiled;
+    int success = compiled && checkProgramLinked(program);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    if (!success) {
+        glDeleteProgram(program);
+        program = 0;
+    }
+    // Program ma być kompletny, zanim użyje go kontekst główny
+    glFinish();
     return program;
 }
 
+static void shaderBuilderThread(ShaderBuilder* builder) {
+    glfwMakeContextCurrent(builder->context);
+    for (;;) {
+        ShaderBuildJob* job;
+        {
+            std::unique_lock<std::mutex> lock(builder->mutex);
+            builder->wake.wait(lock, [builder] { return builder->quit || builder->count > 0; });
+            if (builder->count == 0)
+                break;      // quit i pusta kolejka
+            job = builder->queue[0];
+            builder->count--;
+            memmove(builder->queue, builder->queue + 1, builder->count * sizeof(builder->queue[0]));
+        }
+        job->program = buildShaderJob(job);
+        job->done.store(1);
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
+// Po utworzeniu okna share, w wątku głównym (wymaganie GLFW). Zwraca 0 bez współdzielonego kontekstu.
+int shaderBuilderInit(ShaderBuilder* builder, GLFWwindow* share) {
+    builder->count = 0;
+    builder->quit = 0;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    builder->context = glfwCreateWindow(1, 1, "shader builder", NULL, share);
+    if (!builder->context) {
+        fprintf(stderr, "Brak współdzielonego kontekstu - przeładowanie shaderów może przyciąć klatkę\n");
+        return 0;
+    }
+    builder->thread = std::thread(shaderBuilderThread, builder);
+    return 1;
+}
+
+// Kończy zlecone budowy (ich wyniki odbiera potem collectShaderBuild) i zamyka wątek
+void shaderBuilderFree(ShaderBuilder* builder) {
+    {
+        std::lock_guard<std::mutex> lock(builder->mutex);
+        builder->quit = 1;
+    }
+    builder->wake.notify_all();
+    builder->thread.join();
+    glfwDestroyWindow(builder->context);
+}
+
+// Odbiór zakończonej budowy z wątku (done == 1): zapis do pamięci podręcznej i refleksja w kontekście głównym.
+// Zwraca 0 przy błędzie kompilacji lub linkowania (sp zostaje pusty).
+int collectShaderBuild(ShaderBuildJob* job, ShaderProgram* sp) {
+    job->queued = 0;
+    free(job->vertSource);
+    free(job->fragSource);
+    job->vertSource = job->fragSource = NULL;
+    memset(sp, 0, sizeof(*sp));
+    if (!job->program)
+        return 0;
+    programCacheStore(&shaderCache, job->cacheKey, job->program);
+    reflectShaderProgram(sp, job->program);
+    return 1;
+}
+
+// Przeładowanie programu po zmianie plików: nowa wersja buduje się obok, a stara jest używana,
+// dopóki nowa nie zlinkuje się poprawnie. Błąd w edytowanym shaderze zostawia starą wersję.
+typedef struct {
+    ShaderProgram program;
+    ShaderDependencies deps;    // pliki ostatniej budowy - także nieudanej, np. z brakującym #include
+    const char* vertFile;
+    const char* fragFile;
+    int active;
+    int frames;         // klatki od zlecenia
+    ShaderBuildJob job; // budowa na wątku shaderBuilder (bez GL_KHR_parallel_shader_compile)
+    int restart;        // zapis w trakcie budowy na wątku - po jej końcu budowa od nowa
+} ShaderReload;
+
+void startShaderReload(ShaderReload* reload, const char* vertFile, const char* fragFile) {
+    reload->vertFile = vertFile;
+    reload->fragFile = fragFile;
+    // Budowy na wątku nie da się przerwać - nowa wersja zostanie zlecona po jej zakończeniu
+    if (reload->job.queued) {
+        reload->restart = 1;
+        return;
+    }
+    // Kolejny zapis w trakcie budowy - poprzednia wersja jest już nieaktualna
+    if (reload->active)
+        discardShaderProgram(&reload->program);
+    reload->active = submitShaderProgram(&reload->program, vertFile, fragFile, &reload->deps,
+                                         shaderBuilder ? &reload->job : NULL);
+    reload->frames = 0;
+    if (!reload->active)
+        fprintf(stderr, "Nie można złożyć źródeł %s / %s - zostaje poprzednia wersja\n", vertFile, fragFile);
+}
+
+void watchShaderDependencies(FileWatch* watch, const ShaderDependencies* deps) {
+    for (int i = 0; i < deps->count; i++) {
+        const char* name = fileWatchName(watch, deps->files[i]);
+        if (name)
+            fileWatchAdd(watch, name);
+    }
+}
+
+// Wywoływane raz na klatkę; zwraca 1 gdy target został podmieniony na nową wersję.
+// Bez GL_KHR_parallel_shader_compile program budowany jest na wątku shaderBuilder i tutaj tylko
+// odbierany. Gdy nie udało się utworzyć jego kontekstu, wynik sprawdzamy klatkę po zleceniu -
+// sterownik mógł już skończyć pracę, ale sprawdzenie może poczekać na kompilację.
+int updateShaderReload(ShaderReload* reload, ShaderProgram* target) {
+    if (!reload->active)
+        return 0;
+    reload->frames++;
+    int state;
+    if (reload->job.queued) {
+        if (!reload->job.done.load())
+            return 0;
+        state = collectShaderBuild(&reload->job, &reload->program) ? 1 : -1;
+        if (reload->restart) {
+            reload->restart = 0;
+            discardShaderProgram(&reload->program);
+            startShaderReload(reload, reload->vertFile, reload->fragFile);
+            return 0;
+        }
+    } else if (parallelShaderCompile)
+        state = pollShaderProgram(&reload->program);
+    else
+        state = reload->frames < 2 ? 0 : (finishShaderProgram(&reload->program) ? 1 : -1);
+    if (state == 0)
+        return 0;
+    reload->active = 0;
+    if (state < 0) {
+        fprintf(stderr, "Przeładowanie %s / %s nieudane - zostaje poprzednia wersja\n", reload->vertFile, reload->fragFile);
+        return 0;
+    }
+    // Między klatkami nic nie używa starego programu, więc podmiana jest natychmiastowa
+    discardShaderProgram(target);
+    *target = reload->program;
+    memset(&reload->program, 0, sizeof(reload->program));
+    printf("Przeładowano %s / %s\n", reload->vertFile, reload->fragFile);
+    return 1;
+}
+
 // Struktura wierzchołka - pozycja, normalna, kolor, współrzędne tekstury
 struct Vertex {
     float x, y, z;      // pozycja
@@ -175,106 +627,613 @@ static const Vertex planeVertices[] = {
     {-1.0f,  1.0f, 0.0f,  0.0f, 0.0f, 1.0f,  1.0f, 1.0f, 1.0f,  0.0f, 1.0f},
 };
 
-// Funkcje do tworzenia tekstur proceduralnych
-// Różne wzory dla różnych obiektów
-GLuint createProceduralTexture(int width, int height, int patternType) {
-    unsigned char* data = (unsigned char*)malloc(width * height * 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 3;
-            
-            switch (patternType) {
-                case 0: // Szachownica czarno-biała
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = check * 255;
-                    data[index + 1] = check * 255;
-                    data[index + 2] = check * 255;
-                    break;
-                }
-                case 1: // Czerwono-niebieska szachownica
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = check * 255;
-                    data[index + 1] = 0;
-                    data[index + 2] = (1 - check) * 255;
-                    break;
-                }
-                case 2: // Zielono-żółta szachownica
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = check * 255;
-                    data[index + 1] = 255;
-                    data[index + 2] = (1 - check) * 128;
-                    break;
-                }
-                case 3: // Niebiesko-fioletowa szachownica
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = check * 128;
-                    data[index + 1] = 0;
-                    data[index + 2] = 255;
-                    break;
-                }
-                case 4: // Pomarańczowo-różowa szachownica
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = 255;
-                    data[index + 1] = check * 128;
-                    data[index + 2] = (1 - check) * 200;
-                    break;
-                }
-                default: // Domyślna szachownica
-                {
-                    int check = ((x / 32) + (y / 32)) % 2;
-                    data[index + 0] = check * 255;
-                    data[index + 1] = check * 255;
-                    data[index + 2] = check * 255;
-                    break;
-                }
+// Siatka (mesh) - bufor wierzchołków i obiekty VAO, po jednym na układ atrybutów programu.
+// VAO jest konfigurowany raz przy pierwszym użyciu z danym układem, potem rysowanie to jedno glBindVertexArray.
+#define MAX_MESH_LAYOUTS 8
+
+typedef struct {
+    GLint attribLoc[A_COUNT]; // lokalizacje atrybutów programu (klucz układu)
+    GLuint vao;
+} MeshLayout;
+
+typedef struct {
+    GLuint vbo;
+    GLsizei vertexCount;
+    MeshLayout layouts[MAX_MESH_LAYOUTS];
+    int numLayouts;
+    vec3 boundsMin, boundsMax;  // AABB w układzie modelu
+    vec3 boundsCenter;          // sfera otaczająca w układzie modelu
+    float boundsRadius;
+} Mesh;
+
+// VAO są w rdzeniu od OpenGL 3.0, wcześniej przez GL_ARB_vertex_array_object
+int vertexArraysSupported(void) {
+    return GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_vertex_array_object;
+}
+
+void createMesh(Mesh* mesh, const Vertex* vertices, GLsizei vertexCount) {
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->vertexCount = vertexCount;
+    glGenBuffers(1, &mesh->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertexCount, vertices, GL_STATIC_DRAW);
+    
+    computeBoundingBox(mesh->boundsMin, mesh->boundsMax, vertices, vertexCount, sizeof(Vertex));
+    computeBoundingSphere(mesh->boundsCenter, &mesh->boundsRadius, vertices, vertexCount, sizeof(Vertex));
+}
+
+void destroyMesh(Mesh* mesh) {
+    for (int i = 0; i < mesh->numLayouts; i++)
+        glDeleteVertexArrays(1, &mesh->layouts[i].vao);
+    glDeleteBuffers(1, &mesh->vbo);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+// Ustawienie wskaźników atrybutów struktury Vertex dla podanych lokalizacji
+void setupMeshAttributes(const Mesh* mesh, const GLint* attribLoc) {
+    static const GLint components[A_COUNT] = { 3, 3, 3, 2 };
+    static const size_t offsets[A_COUNT] = {
+        0, sizeof(float) * 3, sizeof(float) * 6, sizeof(float) * 9
+    };
+    
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    for (int a = 0; a < A_COUNT; a++) {
+        if (attribLoc[a] < 0) continue;
+        glEnableVertexAttribArray(attribLoc[a]);
+        glVertexAttribPointer(attribLoc[a], components[a], GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsets[a]);
+    }
+}
+
+// Podpięcie siatki pod program - tworzy VAO dla nowego układu atrybutów, jeśli jeszcze go nie ma
+void bindMesh(Mesh* mesh, const ShaderProgram* program) {
+    if (!vertexArraysSupported()) {
+        setupMeshAttributes(mesh, program->attribLoc);
+        return;
+    }
+    
+    for (int i = 0; i < mesh->numLayouts; i++) {
+        if (memcmp(mesh->layouts[i].attribLoc, program->attribLoc, sizeof(program->attribLoc)) == 0) {
+            glBindVertexArray(mesh->layouts[i].vao);
+            return;
+        }
+    }
+    
+    if (mesh->numLayouts == MAX_MESH_LAYOUTS) {
+        // Nie powinno się zdarzyć przy kilku programach - konfigurujemy pierwszy VAO od nowa
+        fprintf(stderr, "Przekroczono liczbę układów siatki (%d)\n", MAX_MESH_LAYOUTS);
+        glBindVertexArray(mesh->layouts[0].vao);
+        setupMeshAttributes(mesh, program->attribLoc);
+        memcpy(mesh->layouts[0].attribLoc, program->attribLoc, sizeof(program->attribLoc));
+        return;
+    }
+    
+    MeshLayout* layout = &mesh->layouts[mesh->numLayouts++];
+    memcpy(layout->attribLoc, program->attribLoc, sizeof(program->attribLoc));
+    glGenVertexArrays(1, &layout->vao);
+    glBindVertexArray(layout->vao);
+    setupMeshAttributes(mesh, program->attribLoc);
+}
+
+// Kolejka renderowania - obiekty nie są rysowane od razu, tylko zbierane jako pakiety,
+// sortowane po 64-bitowym kluczu (warstwa | program | tekstura | siatka | kolejność)
+// i wykonywane z pamięcią stanu OpenGL, żeby pomijać zbędne glUseProgram/glBindTexture/VAO.
+enum RenderLayer {
+    LAYER_OPAQUE = 0,
+    LAYER_NO_DEPTH = 1   // rysowane na końcu z wyłączonym testem głębi (kostka światła)
+};
+
+typedef struct {
+    int programIndex;
+    GLuint texture;      // 0 = obiekt bez tekstury
+    float textureLayer;  // warstwa w tablicy tekstur (gdy RenderQueue::textureTarget to GL_TEXTURE_2D_ARRAY)
+    Mesh* mesh;
+    int layer;
+    mat4x4 M;
+    mat4x4 MVP;
+    vec3 color;
+} DrawPacket;
+
+typedef struct {
+    uint64_t key;
+    int packet;
+} DrawSortEntry;
+
+// Uniformy wspólne dla całej klatki - ustawiane raz na program, a nie dla każdego obiektu
+typedef struct {
+    mat4x4 V;
+    vec3 lightPos;
+    vec3 lightColor;
+    vec3 viewPos;
+    float time;
+} FrameUniforms;
+
+// Liczniki z ostatniej klatki: wykonane zmiany stanu i te pominięte bo stan już się zgadzał
+typedef struct {
+    int draws;
+    int triangles;
+    int programChanges, programChangesSkipped;
+    int textureChanges, textureChangesSkipped;
+    int meshChanges, meshChangesSkipped;
+} RenderStats;
+
+#define MAX_QUEUE_PROGRAMS 16
+
+// Strefy pomiaru czasu GPU: cała klatka, przebiegi (warstwy) i partie materiałów (programów)
+enum GpuZone {
+    GPU_ZONE_FRAME,
+    GPU_ZONE_PASS,                          // + warstwa
+    GPU_ZONE_MATERIAL = GPU_ZONE_PASS + 2,  // + indeks programu
+    GPU_ZONE_COUNT = GPU_ZONE_MATERIAL + 5
+};
+
+static const char* const gpuZoneNames[GPU_ZONE_COUNT] = {
+    "klatka", "przebieg_nieprzezroczyste", "przebieg_bez_glebi",
+    "diffuse", "specular", "blinn_phong", "texture", "flag"
+};
+
+typedef struct {
+    ShaderProgram* programs;
+    int numPrograms;
+    DrawPacket* packets;
+    DrawSortEntry* order;
+    int count;
+    int capacity;
+    RenderStats stats;
+    GpuTimer* timer;     // NULL = bez pomiaru czasu przebiegów i materiałów
+    GLenum textureTarget; // GL_TEXTURE_2D albo GL_TEXTURE_2D_ARRAY (wszystkie materiały w jednej tablicy)
+} RenderQueue;
+
+void initRenderQueue(RenderQueue* queue, ShaderProgram* programs, int numPrograms) {
+    memset(queue, 0, sizeof(*queue));
+    queue->programs = programs;
+    queue->numPrograms = numPrograms;
+    queue->textureTarget = GL_TEXTURE_2D;
+}
+
+void destroyRenderQueue(RenderQueue* queue) {
+    free(queue->packets);
+    free(queue->order);
+    memset(queue, 0, sizeof(*queue));
+}
+
+// Zwraca miejsce na nowy pakiet (tablice rosną dwukrotnie w razie potrzeby)
+DrawPacket* submitDraw(RenderQueue* queue) {
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 64;
+        DrawPacket* packets = (DrawPacket*)realloc(queue->packets, sizeof(DrawPacket) * capacity);
+        DrawSortEntry* order = (DrawSortEntry*)realloc(queue->order, sizeof(DrawSortEntry) * capacity);
+        if (!packets || !order) {
+            fprintf(stderr, "Brak pamięci na kolejkę renderowania\n");
+            exit(EXIT_FAILURE);
+        }
+        queue->packets = packets;
+        queue->order = order;
+        queue->capacity = capacity;
+    }
+    DrawPacket* packet = &queue->packets[queue->count++];
+    memset(packet, 0, sizeof(*packet));
+    return packet;
+}
+
+// Klucz: warstwa (4 bity) | program (8) | tekstura (16) | siatka (16) | kolejność zgłoszenia (20)
+static uint64_t makeDrawKey(const DrawPacket* packet, int sequence) {
+    return ((uint64_t)(packet->layer & 0xF) << 60) |
+           ((uint64_t)(packet->programIndex & 0xFF) << 52) |
+           ((uint64_t)(packet->texture & 0xFFFF) << 36) |
+           ((uint64_t)(packet->mesh->vbo & 0xFFFF) << 20) |
+           (uint64_t)(sequence & 0xFFFFF);
+}
+
+static int compareDrawKeys(const void* a, const void* b) {
+    uint64_t ka = ((const DrawSortEntry*)a)->key;
+    uint64_t kb = ((const DrawSortEntry*)b)->key;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static void uploadFrameUniforms(const ShaderProgram* program, const FrameUniforms* frame) {
+    if (program->uniformLoc[U_V] >= 0) glUniformMatrix4fv(program->uniformLoc[U_V], 1, GL_FALSE, (const GLfloat*)frame->V);
+    if (program->uniformLoc[U_LIGHT_POS] >= 0) glUniform3fv(program->uniformLoc[U_LIGHT_POS], 1, frame->lightPos);
+    if (program->uniformLoc[U_LIGHT_COLOR] >= 0) glUniform3fv(program->uniformLoc[U_LIGHT_COLOR], 1, frame->lightColor);
+    if (program->uniformLoc[U_VIEW_POS] >= 0) glUniform3fv(program->uniformLoc[U_VIEW_POS], 1, frame->viewPos);
+    if (program->uniformLoc[U_TIME] >= 0) glUniform1f(program->uniformLoc[U_TIME], frame->time);
+    if (program->uniformLoc[U_TEXTURE_SAMPLER] >= 0) glUniform1i(program->uniformLoc[U_TEXTURE_SAMPLER], 0);
+}
+
+// Sortowanie i wykonanie pakietów, po czym kolejka jest czyszczona
+void flushRenderQueue(RenderQueue* queue, const FrameUniforms* frame) {
+    RenderStats* stats = &queue->stats;
+    memset(stats, 0, sizeof(*stats));
+    
+    profilerBegin("sortowanie");
+    for (int i = 0; i < queue->count; i++) {
+        queue->order[i].key = makeDrawKey(&queue->packets[i], i);
+        queue->order[i].packet = i;
+    }
+    qsort(queue->order, queue->count, sizeof(DrawSortEntry), compareDrawKeys);
+    profilerEnd();
+    
+    int frameUniformsSet[MAX_QUEUE_PROGRAMS] = { 0 };
+    const ShaderProgram* currentProgram = NULL;
+    GLuint currentTexture = 0;
+    const Mesh* currentMesh = NULL;
+    int depthTest = 1;
+    int currentLayer = -1;
+    
+    profilerBegin("rysowanie");
+    glActiveTexture(GL_TEXTURE0);
+    for (int i = 0; i < queue->count; i++) {
+        const DrawPacket* packet = &queue->packets[queue->order[i].packet];
+        ShaderProgram* program = &queue->programs[packet->programIndex];
+        requireShaderProgram(program);
+        
+        // Pakiety są posortowane po warstwie i programie, więc każda strefa to ciągły odcinek
+        if (queue->timer && (packet->layer != currentLayer || program != currentProgram)) {
+            if (currentProgram)
+                gpuTimerEnd(queue->timer, GPU_ZONE_MATERIAL + (int)(currentProgram - queue->programs));
+            if (packet->layer != currentLayer) {
+                if (currentLayer >= 0)
+                    gpuTimerEnd(queue->timer, GPU_ZONE_PASS + currentLayer);
+                gpuTimerBegin(queue->timer, GPU_ZONE_PASS + packet->layer);
             }
+            gpuTimerBegin(queue->timer, GPU_ZONE_MATERIAL + packet->programIndex);
         }
+        currentLayer = packet->layer;
+        
+        if (program != currentProgram) {
+            glUseProgram(program->id);
+            stats->programChanges++;
+            if (packet->programIndex < MAX_QUEUE_PROGRAMS && !frameUniformsSet[packet->programIndex]) {
+                profilerBegin("uniformy");
+                uploadFrameUniforms(program, frame);
+                profilerEnd();
+                frameUniformsSet[packet->programIndex] = 1;
+            }
+        } else {
+            stats->programChangesSkipped++;
+        }
+        
+        if (packet->texture) {
+            if (packet->texture != currentTexture) {
+                glBindTexture(queue->textureTarget, packet->texture);
+                currentTexture = packet->texture;
+                stats->textureChanges++;
+            } else {
+                stats->textureChangesSkipped++;
+            }
+        }
+        
+        // VAO zależy od pary (siatka, układ atrybutów programu)
+        if (packet->mesh != currentMesh || !currentProgram ||
+            memcmp(program->attribLoc, currentProgram->attribLoc, sizeof(program->attribLoc)) != 0) {
+            bindMesh(packet->mesh, program);
+            currentMesh = packet->mesh;
+            stats->meshChanges++;
+        } else {
+            stats->meshChangesSkipped++;
+        }
+        currentProgram = program;
+        
+        int wantDepth = packet->layer != LAYER_NO_DEPTH;
+        if (wantDepth != depthTest) {
+            if (wantDepth) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+            depthTest = wantDepth;
+        }
+        
+        if (program->uniformLoc[U_MVP] >= 0) glUniformMatrix4fv(program->uniformLoc[U_MVP], 1, GL_FALSE, (const GLfloat*)packet->MVP);
+        if (program->uniformLoc[U_M] >= 0) glUniformMatrix4fv(program->uniformLoc[U_M], 1, GL_FALSE, (const GLfloat*)packet->M);
+        if (program->uniformLoc[U_OBJECT_COLOR] >= 0) glUniform3fv(program->uniformLoc[U_OBJECT_COLOR], 1, packet->color);
+        if (program->uniformLoc[U_TEXTURE_LAYER] >= 0) glUniform1f(program->uniformLoc[U_TEXTURE_LAYER], packet->textureLayer);
+        
+        glDrawArrays(GL_TRIANGLES, 0, packet->mesh->vertexCount);
+        stats->draws++;
+        stats->triangles += packet->mesh->vertexCount / 3;
     }
     
+    if (queue->timer && currentProgram) {
+        gpuTimerEnd(queue->timer, GPU_ZONE_MATERIAL + (int)(currentProgram - queue->programs));
+        gpuTimerEnd(queue->timer, GPU_ZONE_PASS + currentLayer);
+    }
+    if (!depthTest) glEnable(GL_DEPTH_TEST);
+    profilerEnd();
+    queue->count = 0;
+}
+
+// Mipmapy i próbkowanie tekstur (--mipmaps, --anisotropy); tryb AUTO rozstrzygany po gladLoadGL
+static TextureFiltering textureFiltering = { MIPMAPS_AUTO, 1, 8.0f };
+
+// Tablice tekstur: w core profile od OpenGL 3.0, w kontekście 2.0 przez GL_EXT_texture_array
+// (rozszerzenie udostępnia też sampler2DArray w GLSL 110)
+int textureArraysSupported(void) {
+    return coreProfile ? GLAD_GL_VERSION_3_0 : GLAD_GL_EXT_texture_array;
+}
+
+// Zakres poziomów, filtrowanie i powtarzanie tekstury podpiętej pod target
+static void setTextureSampling(GLenum target, int levels) {
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    mipApplyFiltering(target, &textureFiltering, levels > 1);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+// Tekstura RGB z gotowych łańcuchów mipmap - poziom 0 wypełniony, pozostałe liczone tutaj
+// na wątkach puli (MIPMAPS_CPU) albo przez sterownik (MIPMAPS_GPU).
+// GL_TEXTURE_2D z jednego łańcucha albo GL_TEXTURE_2D_ARRAY z layers łańcuchów tego samego rozmiaru.
+GLuint createTexture(ThreadPool* pool, GLenum target, MipChain* chains, int layers) {
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    
-    free(data);
+    glBindTexture(target, texture);
+    int levels = 1;
+    if (textureFiltering.mode == MIPMAPS_CPU && chains[0].levels > 1) {
+        for (int layer = 0; layer < layers; layer++)
+            mipChainBuild(&chains[layer], pool);
+        levels = chains[0].levels;
+    }
+    // Wiersze RGB nie są wyrównane do 4 bajtów dla szerokości niepodzielnych przez 4
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < levels; level++) {
+        int width = chains[0].width[level], height = chains[0].height[level];
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glTexImage3D(target, level, GL_RGB, width, height, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+            for (int layer = 0; layer < layers; layer++)
+                glTexSubImage3D(target, level, 0, 0, layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                                chains[layer].pixels + chains[layer].offset[level]);
+        } else {
+            glTexImage2D(target, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                         chains[0].pixels + chains[0].offset[level]);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (textureFiltering.mode == MIPMAPS_GPU && chains[0].levels > 1) {
+        glGenerateMipmap(target);
+        levels = chains[0].levels;
+    }
+    setTextureSampling(target, levels);
     return texture;
 }
 
-// Funkcja do tworzenia żółtej tekstury (dla słońca)
-GLuint createYellowTexture(int width, int height) {
-    unsigned char* data = (unsigned char*)malloc(width * height * 3);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 3;
-            // Żółty kolor
-            data[index + 0] = 255; // R
-            data[index + 1] = 255; // G
-            data[index + 2] = 0;    // B
-        }
-    }
-    
+// BC1 (S3TC DXT1) - rozszerzenie mają praktycznie wszystkie sterowniki na PC
+int textureCompressionSupported(void) {
+    return GLAD_GL_EXT_texture_compression_s3tc;
+}
+
+// Tekstura BC1 z zakodowanych łańcuchów (texcompress.h) - bloki idą do sterownika bez przeliczania,
+// a wszystkie poziomy mipmap są już w łańcuchu (glGenerateMipmap nie działa dla formatów skompresowanych)
+GLuint createCompressedTexture(GLenum target, const CompressedChain* chains, int layers) {
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    
-    free(data);
+    glBindTexture(target, texture);
+    for (int level = 0; level < chains[0].levels; level++) {
+        int width = chains[0].width[level], height = chains[0].height[level];
+        GLsizei size = (GLsizei)chains[0].size[level];
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glCompressedTexImage3D(target, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, layers, 0,
+                                   size * layers, NULL);
+            for (int layer = 0; layer < layers; layer++)
+                glCompressedTexSubImage3D(target, level, 0, 0, layer, width, height, 1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                          size, chains[layer].blocks + chains[layer].offset[level]);
+        } else {
+            glCompressedTexImage2D(target, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, 0, size,
+                                   chains[0].blocks + chains[0].offset[level]);
+        }
+    }
+    setTextureSampling(target, chains[0].levels);
     return texture;
 }
 
+// Funkcje do tworzenia tekstur proceduralnych
+// Różne wzory dla różnych obiektów (texturePatterns w texsynth.h) - wszystkie generowane naraz
+// na wątkach puli, a do OpenGL wysyłane po kolei z wątku głównego.
+// Z textureArray wszystkie wzory są warstwami jednej tablicy (warstwa = indeks wzoru), a textures[i]
+// to ta sama tekstura - obiekty różniące się wzorem rysuje się bez przełączania tekstur.
+// Z compression (nie NULL) tekstury są w BC1: łańcuch z pamięci podręcznej albo mipmapy na CPU
+// i kodowanie na wątkach puli. Zwraca bajty tekstur wysłane do sterownika.
+size_t createProceduralTextures(ThreadPool* pool, int width, int height, GLuint* textures, int count, int textureArray,
+                                TextureCache* compression) {
+    TextureSynthesis synths[PATTERN_COUNT];
+    MipChain chains[PATTERN_COUNT];
+    CompressedChain compressed[PATTERN_COUNT];
+    TexCompressJob jobs[PATTERN_COUNT];
+    uint64_t keys[PATTERN_COUNT];
+    int encoding[PATTERN_COUNT] = { 0 };
+    for (int i = 0; i < count; i++) {
+        // Bez mipmap bufor ma tylko poziom 0
+        int mipmaps = textureFiltering.mode != MIPMAPS_OFF;
+        if (!mipChainAlloc(&chains[i], width, height, mipmaps) ||
+            !texSynthBegin(&synths[i], pool, &texturePatterns[i], width, height, chains[i].pixels)) {
+            fprintf(stderr, "Brak pamięci na teksturę %dx%d\n", width, height);
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t bytes = 0;
+    if (compression) {
+        texCompressInit();
+        for (int i = 0; i < count; i++) {
+            texSynthEnd(&synths[i], pool);
+            keys[i] = textureCacheKey(&chains[i]);
+            if (textureCacheLoad(compression, keys[i], &chains[i], &compressed[i]))
+                continue;
+            // Kodowanie tej tekstury idzie na wątkach, gdy wątek główny liczy mipmapy następnej
+            mipChainBuild(&chains[i], pool);
+            if (!texCompressBegin(&jobs[i], pool, &chains[i], &compressed[i])) {
+                fprintf(stderr, "Brak pamięci na teksturę %dx%d\n", width, height);
+                exit(EXIT_FAILURE);
+            }
+            encoding[i] = 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (encoding[i]) {
+                texCompressEnd(&jobs[i], pool);
+                textureCacheStore(compression, keys[i], &compressed[i]);
+            }
+            if (!textureArray)
+                textures[i] = createCompressedTexture(GL_TEXTURE_2D, &compressed[i], 1);
+            bytes += compressed[i].totalSize;
+        }
+        if (textureArray) {
+            GLuint texture = createCompressedTexture(GL_TEXTURE_2D_ARRAY, compressed, count);
+            for (int i = 0; i < count; i++)
+                textures[i] = texture;
+        }
+        for (int i = 0; i < count; i++) {
+            compressedChainFree(&compressed[i]);
+            mipChainFree(&chains[i]);
+        }
+        return bytes;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        texSynthEnd(&synths[i], pool);
+        if (!textureArray)
+            textures[i] = createTexture(pool, GL_TEXTURE_2D, &chains[i], 1);
+        bytes += mipChainBytes(&chains[i]);
+    }
+    if (textureArray) {
+        GLuint texture = createTexture(pool, GL_TEXTURE_2D_ARRAY, chains, count);
+        for (int i = 0; i < count; i++)
+            textures[i] = texture;
+    }
+    for (int i = 0; i < count; i++)
+        mipChainFree(&chains[i]);
+    return bytes;
+}
+
+// Wymiana tekstur materiałów na większe w trakcie działania (klawisz H, --stream-textures).
+// Nowe tekstury razem z poziomami mipmap dochodzą paskami przez texstream.h; stare rysują do czasu podmiany.
+typedef struct {
+    int active;
+    int settleFrames;   // klatki po podmianie, które jeszcze wchodzą do najdłuższej klatki
+    int size;
+    int levels;
+    GLenum target;
+    GLuint textures[PATTERN_COUNT];         // przy tablicy tekstur wszystkie to ta sama tekstura
+    // Tylko dwa wiersze każdego poziomu wzoru - paski kopiowane prosto do PBO
+    TextureSynthesis synths[MIP_MAX_LEVELS][PATTERN_COUNT];
+    TexStreamRequest requests[PATTERN_COUNT];
+    int numRequests;
+    double startTime;
+    double streamMs;
+    int frames;
+    float longestFrameMs;
+} TextureSwap;
+
+static void streamPatternRows(void* arg, int level, int layer, int begin, int end, unsigned char* dst) {
+    texSynthCopyRows((const TextureSynthesis*)arg + level * PATTERN_COUNT + layer, begin, end, dst);
+}
+
+static void releaseSwapSynths(TextureSwap* swap) {
+    for (int level = 0; level < swap->levels; level++) {
+        for (int i = 0; i < PATTERN_COUNT; i++)
+            texSynthRelease(&swap->synths[level][i]);
+    }
+}
+
+// Puste tekstury size x size ze wszystkimi poziomami mipmap i żądania strumienia.
+// Zwraca 0, gdy strumień jest niedostępny albo poprzednia wymiana jeszcze trwa.
+int startTextureSwap(TextureSwap* swap, TexStream* stream, int size, int textureArray) {
+    if (!stream->supported || swap->active || swap->settleFrames > 0)
+        return 0;
+    swap->levels = textureFiltering.mode != MIPMAPS_OFF ? mipLevelCount(size, size) : 1;
+    for (int level = 0; level < swap->levels; level++) {
+        for (int i = 0; i < PATTERN_COUNT; i++) {
+            if (!texSynthPrepareLevel(&swap->synths[level][i], &texturePatterns[i], size, size, level)) {
+                fprintf(stderr, "Brak pamięci na teksturę %dx%d\n", size, size);
+                for (int j = 0; j < i; j++)
+                    texSynthRelease(&swap->synths[level][j]);
+                swap->levels = level;
+                releaseSwapSynths(swap);
+                return 0;
+            }
+        }
+    }
+    swap->size = size;
+    swap->target = textureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    swap->numRequests = textureArray ? 1 : PATTERN_COUNT;
+    for (int r = 0; r < swap->numRequests; r++) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(swap->target, texture);
+        for (int level = 0; level < swap->levels; level++) {
+            int levelSize = texStreamLevelSize(size, level);
+            if (textureArray)
+                glTexImage3D(swap->target, level, GL_RGB, levelSize, levelSize, PATTERN_COUNT, 0, GL_RGB,
+                             GL_UNSIGNED_BYTE, NULL);
+            else
+                glTexImage2D(swap->target, level, GL_RGB, levelSize, levelSize, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        }
+        TexStreamRequest* request = &swap->requests[r];
+        request->texture = texture;
+        request->target = swap->target;
+        request->width = request->height = size;
+        request->layers = textureArray ? PATTERN_COUNT : 1;
+        request->levels = swap->levels;
+        request->fill = streamPatternRows;
+        request->arg = &swap->synths[0][textureArray ? 0 : r];
+        texStreamSubmit(stream, request);
+        for (int i = 0; i < PATTERN_COUNT; i++) {
+            if (textureArray || i == r)
+                swap->textures[i] = texture;
+        }
+    }
+    swap->active = 1;
+    swap->startTime = glfwGetTime();
+    swap->frames = 0;
+    swap->longestFrameMs = 0.0f;
+    return 1;
+}
+
+// Raz na klatkę po texStreamUpdate z czasem poprzedniej klatki; gdy wszystkie paski są w teksturach -
+// podmiana patternTextures (stare usuwane) i zwrot 1. Czas klatki z podmianą przychodzi dopiero
+// w następnym wywołaniu, więc podsumowanie wypisywane jest po pierwszej klatce po podmianie.
+int updateTextureSwap(TextureSwap* swap, float frameMs, GLuint* patternTextures) {
+    if (swap->settleFrames > 0) {
+        if (frameMs > swap->longestFrameMs)
+            swap->longestFrameMs = frameMs;
+        if (--swap->settleFrames == 0) {
+            double bytes = 0.0;
+            for (int level = 0; level < swap->levels; level++) {
+                double levelSize = texStreamLevelSize(swap->size, level);
+                bytes += levelSize * levelSize * 3 * PATTERN_COUNT;
+            }
+            printf("Tekstury %dx%d przesłane strumieniem (poziomów mipmap: %d): %.1f MB w %d klatkach (%.1f ms), "
+                   "najdłuższa klatka do pierwszej po podmianie %.2f ms\n", swap->size, swap->size, swap->levels,
+                   bytes / (1024.0 * 1024.0), swap->frames, swap->streamMs, swap->longestFrameMs);
+        }
+        return 0;
+    }
+    if (!swap->active)
+        return 0;
+    // Pierwszy czas to klatka sprzed startTextureSwap
+    if (swap->frames > 0 && frameMs > swap->longestFrameMs)
+        swap->longestFrameMs = frameMs;
+    swap->frames++;
+    for (int r = 0; r < swap->numRequests; r++) {
+        if (!texStreamRequestDone(&swap->requests[r]))
+            return 0;
+    }
+    for (int r = 0; r < swap->numRequests; r++) {
+        glBindTexture(swap->target, swap->requests[r].texture);
+        setTextureSampling(swap->target, swap->levels);
+    }
+    glDeleteTextures(PATTERN_COUNT, patternTextures);
+    for (int i = 0; i < PATTERN_COUNT; i++)
+        patternTextures[i] = swap->textures[i];
+    releaseSwapSynths(swap);
+    swap->active = 0;
+    swap->streamMs = (glfwGetTime() - swap->startTime) * 1000.0;
+    swap->settleFrames = 2;     // klatka z podmianą i pierwsza po niej
+    return 1;
+}
+
+// Przerwana wymiana (zamknięcie w trakcie) - po texStreamFree, więc nikt już nie pisze z synths
+void freeTextureSwap(TextureSwap* swap) {
+    if (!swap->active)
+        return;
+    for (int r = 0; r < swap->numRequests; r++)
+        glDeleteTextures(1, &swap->requests[r].texture);
+    releaseSwapSynths(swap);
+    swap->active = 0;
+}
+
 // SEKCJA 4: STRUKTURY KAMERY I APLIKACJ
 typedef struct {
     vec3 position;
@@ -309,23 +1268,65 @@ typedef struct {
     
     SceneObject objects[5];
     int numObjects;
+    int pickRequested; // klawisz P - wybranie obiektu na środku ekranu
+    int traceRequested; // klawisz T - zapis stref CPU do pliku Chrome trace
+    int showOverlay;    // klawisz O - nakładka ze statystykami i wykresem czasu klatki
+    int streamRequested; // klawisz H - wymiana tekstur na większe przesyłane strumieniem
 } AppState;
 
 
 // SEKCJA 5: FUNKCJE POMOCNICZE KAMERY
 
 
+// Macierz kamery Wc = T * Ry(yaw) * Rx(pitch) jako przekształcenie sztywne (obrót + przesunięcie)
+void getCameraTransform(rigid* Wc, const Camera* camera) {
+    quat qy, qx;
+    vec3 yAxis = { 0.0f, 1.0f, 0.0f };
+    vec3 xAxis = { 1.0f, 0.0f, 0.0f };
+    quat_rotate(qy, camera->yaw, yAxis);
+    quat_rotate(qx, camera->pitch, xAxis);
+    quat_mul(Wc->q, qy, qx);
+    vec3_dup(Wc->t, camera->position);
+}
+
 void calculateViewMatrix(mat4x4 V, const Camera* camera) {
-    mat4x4 Wc, T, Ry, Rx;
-    mat4x4_translate(T, camera->position[0], camera->position[1], camera->position[2]);
-    mat4x4_identity(Ry);
-    mat4x4_rotate_Y(Ry, Ry, camera->yaw);
-    mat4x4_identity(Rx);
-    mat4x4_rotate_X(Rx, Rx, camera->pitch);
-    mat4x4_mul(Wc, Ry, Rx);
-    mat4x4_mul(Wc, T, Wc);
-    mat4x4_invert(V, Wc);
+    rigid Wc, invWc;
+    getCameraTransform(&Wc, camera);
+    rigid_invert(&invWc, &Wc);  // macierz widoku to odwrotność macierzy kamery - bez ogólnego mat4x4_invert
+    mat4x4_from_rigid(V, &invWc);
+}
+
+#ifdef _DEBUG
+// Porównanie z dawną drogą przez mat4x4_invert dla siatki położeń i kątów kamery
+static void checkViewMatrix(void) {
+    float maxError = 0.0f;
+    for (int step = 0; step < 1000; step++) {
+        Camera camera;
+        camera.position[0] = (float)(step % 10) * 3.0f - 15.0f;
+        camera.position[1] = (float)(step / 10 % 10) * 3.0f - 15.0f;
+        camera.position[2] = (float)(step / 100) * 3.0f - 15.0f;
+        camera.yaw = (float)step * 0.37f;
+        camera.pitch = ((float)(step % 17) / 16.0f - 0.5f) * 3.0f;
+
+        mat4x4 Wc, T, Ry, Rx, expected, V;
+        mat4x4_translate(T, camera.position[0], camera.position[1], camera.position[2]);
+        mat4x4_identity(Ry);
+        mat4x4_rotate_Y(Ry, Ry, camera.yaw);
+        mat4x4_identity(Rx);
+        mat4x4_rotate_X(Rx, Rx, camera.pitch);
+        mat4x4_mul(Wc, Ry, Rx);
+        mat4x4_mul(Wc, T, Wc);
+        mat4x4_invert(expected, Wc);
+
+        calculateViewMatrix(V, &camera);
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                maxError = fmaxf(maxError, fabsf(V[c][r] - expected[c][r]));
+    }
+    if (maxError > 1e-4f)
+        fprintf(stderr, "calculateViewMatrix: odchylenie od mat4x4_invert %g\n", maxError);
 }
+#endif
 
 void getCameraForward(vec3 forward, const Camera* camera) {
     forward[0] = -sinf(camera->yaw) * cosf(camera->pitch);
@@ -377,6 +1378,18 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     if (key == GLFW_KEY_C) {
         app->keyC = (action == GLFW_PRESS || action == GLFW_REPEAT);
     }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        app->pickRequested = 1;
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        app->traceRequested = 1;
+    }
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        app->showOverlay = !app->showOverlay;
+    }
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+        app->streamRequested = 1;
+    }
 }
 
 static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -441,6 +1454,10 @@ void initAppState(AppState* app) {
     // Inicjalizacja 5 obiektów - każdy z innym materiałem zgodnie z wymaganiami
     // 0=diffuse, 1=specular, 2=blinn-phong, 3=texture, 4=flag
     app->numObjects = 5;
+    app->pickRequested = 0;
+    app->traceRequested = 0;
+    app->showOverlay = 0;
+    app->streamRequested = 0;
     
     // Obiekt 1: Model światła rozproszonego (diffuse) - niebieski
     app->objects[0].position[0] = -4.0f; app->objects[0].position[1] = 0.0f; app->objects[0].position[2] = 0.0f;
@@ -473,19 +1490,266 @@ void initAppState(AppState* app) {
     app->objects[4].color[0] = 1.0f; app->objects[4].color[1] = 0.0f; app->objects[4].color[2] = 1.0f;
 }
 
+// Przeniesienie stanu kamery i światła do/z klatki nagrania
+static void capturePathFrame(const AppState* app, CameraPathFrame* frame) {
+    memcpy(frame->position, app->camera.position, sizeof(frame->position));
+    frame->yaw = app->camera.yaw;
+    frame->pitch = app->camera.pitch;
+    frame->fov = app->fov;
+    memcpy(frame->light, app->light.position, sizeof(frame->light));
+}
+
+static void applyPathFrame(AppState* app, const CameraPathFrame* frame) {
+    memcpy(app->camera.position, frame->position, sizeof(frame->position));
+    app->camera.yaw = frame->yaw;
+    app->camera.pitch = frame->pitch;
+    app->fov = frame->fov;
+    memcpy(app->light.position, frame->light, sizeof(frame->light));
+}
+
+// Panel nakładki: FPS ze średniej wykresu, czasy CPU/GPU, liczniki ostatniej klatki i wykres
+static void drawStatsOverlay(Overlay* overlay, int width, int height, float cpuMs, float gpuMs,
+                             const RenderStats* st, int culled) {
+    float frameSum = 0.0f;
+    for (int i = 0; i < OVERLAY_GRAPH_FRAMES; i++)
+        frameSum += overlay->frameMs[i];
+    float fps = frameSum > 0.0f ? 1000.0f * OVERLAY_GRAPH_FRAMES / frameSum : 0.0f;
+    
+    char lines[7][32];
+    snprintf(lines[0], sizeof(lines[0]), "FPS       %.0f", fps);
+    snprintf(lines[1], sizeof(lines[1]), "CPU       %.2f MS", cpuMs);
+    snprintf(lines[2], sizeof(lines[2]), "GPU       %.2f MS", gpuMs);
+    snprintf(lines[3], sizeof(lines[3]), "RYSOWANIA %d", st->draws);
+    snprintf(lines[4], sizeof(lines[4]), "PROGRAMY  %d", st->programChanges);
+    snprintf(lines[5], sizeof(lines[5]), "TROJKATY  %d", st->triangles);
+    snprintf(lines[6], sizeof(lines[6]), "ODRZUCONE %d", culled);
+    
+    const float x = 8.0f, y = 8.0f, pad = 8.0f, lineH = 18.0f, graphW = 256.0f, graphH = 64.0f;
+    overlayBegin(overlay);
+    overlayRect(overlay, x, y, graphW + 2.0f * pad, 7 * lineH + graphH + 3.0f * pad, 0x000000A0u);
+    for (int i = 0; i < 7; i++)
+        overlayText(overlay, x + pad, y + pad + i * lineH, 2.0f, lines[i], 0xFFFFFFFFu);
+    overlayGraph(overlay, x + pad, y + 2.0f * pad + 7 * lineH, graphW, graphH, 50.0f);
+    overlayDraw(overlay, width, height);
+}
+
+// Pomiar próbkowania tekstury w oddali: podłoga z kafli 8x8 z szachownicą 1024x1024 uciekająca
+// do horyzontu, rysowana przy kolejnych ustawieniach filtrowania. Bez mipmap odległe kafle czytają
+// rozrzucone teksele z poziomu 0 (4 MB na teksturę), z mipmapami - małe poziomy, które mieszczą się
+// w pamięci podręcznej tekstur; anizotropia dokłada próbek tylko na kaflach widzianych pod kątem.
+#define FILTER_BENCH_TEXTURE 1024
+#define FILTER_BENCH_FRAMES 20
+
+// target - GL_TEXTURE_2D_ARRAY, gdy shadery próbkują tablicę tekstur (tekstura to wtedy tablica z jedną warstwą)
+static void runFilterBenchmark(ThreadPool* pool, ShaderProgram* program, Mesh* plane, GLenum target, int width, int height) {
+    // Na potrzeby pomiaru mipmapy są zawsze, także przy --mipmaps off
+    int savedMode = textureFiltering.mode;
+    if (textureFiltering.mode == MIPMAPS_OFF)
+        textureFiltering.mode = mipResolveMode(MIPMAPS_AUTO);
+    MipChain chain;
+    if (!mipChainAlloc(&chain, FILTER_BENCH_TEXTURE, FILTER_BENCH_TEXTURE, 1) ||
+        !texSynthGenerate(pool, &texturePatterns[PATTERN_BLACK_WHITE], FILTER_BENCH_TEXTURE, FILTER_BENCH_TEXTURE,
+                          chain.pixels)) {
+        fprintf(stderr, "Brak pamięci na teksturę %dx%d\n", FILTER_BENCH_TEXTURE, FILTER_BENCH_TEXTURE);
+        exit(EXIT_FAILURE);
+    }
+    GLuint texture = createTexture(pool, target, &chain, 1);
+    mipChainFree(&chain);
+    textureFiltering.mode = savedMode;
+    
+    // Kamera metr nad podłogą, lekko w dół; kafle od -64 do 64 w X i do -256 w Z
+    Camera camera = { { 0.0f, 1.0f, 0.0f }, 0.0f, -0.15f };
+    mat4x4 P, V, VP;
+    mat4x4_perspective(P, 60.0f * (float)M_PI / 180.0f, (float)width / (float)height, 0.1f, 300.0f);
+    calculateViewMatrix(V, &camera);
+    mat4x4_mul(VP, P, V);
+    
+    int useQuery = GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_timer_query;
+    GLuint query = 0;
+    if (useQuery)
+        glGenQueries(1, &query);
+    float maxAnisotropy = mipMaxAnisotropy();
+    struct { const char* name; int mipmaps, trilinear; float anisotropy; } modes[] = {
+        { "bez mipmap (GL_LINEAR)",     0, 0, 1.0f },
+        { "mipmapy, dwuliniowe",        1, 0, 1.0f },
+        { "mipmapy, trójliniowe",       1, 1, 1.0f },
+        { "trójliniowe + anizotropia",  1, 1, textureFiltering.anisotropy },
+    };
+    int numModes = maxAnisotropy > 1.0f && textureFiltering.anisotropy > 1.0f ? 4 : 3;
+    printf("Filtrowanie tekstury %dx%d w oddali (%dx%d, %d klatek, anizotropia maks. %.0f):\n",
+           FILTER_BENCH_TEXTURE, FILTER_BENCH_TEXTURE, width, height, FILTER_BENCH_FRAMES, maxAnisotropy);
+    
+    glViewport(0, 0, width, height);
+    requireShaderProgram(program);
+    glUseProgram(program->id);
+    bindMesh(plane, program);
+    if (program->uniformLoc[U_TEXTURE_SAMPLER] >= 0) glUniform1i(program->uniformLoc[U_TEXTURE_SAMPLER], 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(target, texture);
+    if (program->uniformLoc[U_TEXTURE_LAYER] >= 0) glUniform1f(program->uniformLoc[U_TEXTURE_LAYER], 0.0f);
+    // Czas GPU z GL_TIME_ELAPSED i czas ściany do glFinish - renderery programowe (np. llvmpipe)
+    // rasteryzują dopiero przy glFinish, więc ich zapytanie nie obejmuje próbkowania
+    printf("  %-10s %-12s %s\n", "GPU [ms]", "ściana [ms]", "filtrowanie");
+    double baseMs = 0.0;
+    for (int m = 0; m < numModes; m++) {
+        TextureFiltering filtering = { textureFiltering.mode, modes[m].trilinear, modes[m].anisotropy };
+        mipApplyFiltering(target, &filtering, modes[m].mipmaps);
+        double gpuMs = 0.0, wallMs = 0.0;
+        for (int frame = -2; frame < FILTER_BENCH_FRAMES; frame++) {   // dwie klatki rozgrzewki
+            glFinish();
+            double start = glfwGetTime();
+            if (useQuery) glBeginQuery(GL_TIME_ELAPSED, query);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (int z = 0; z < 32; z++) {
+                for (int x = 0; x < 16; x++) {
+                    mat4x4 M, MVP;
+                    mat4x4_translate(M, (float)x * 8.0f - 60.0f, 0.0f, -(float)z * 8.0f - 4.0f);
+                    mat4x4_rotate_X(M, M, -(float)M_PI / 2.0f);
+                    mat4x4_scale_aniso(M, M, 4.0f, 4.0f, 1.0f);
+                    mat4x4_mul(MVP, VP, M);
+                    glUniformMatrix4fv(program->uniformLoc[U_MVP], 1, GL_FALSE, (const GLfloat*)MVP);
+                    glDrawArrays(GL_TRIANGLES, 0, plane->vertexCount);
+                }
+            }
+            if (useQuery) glEndQuery(GL_TIME_ELAPSED);
+            glFinish();
+            if (frame < 0)
+                continue;
+            wallMs += (glfwGetTime() - start) * 1000.0;
+            if (useQuery) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+                gpuMs += (double)ns / 1e6;
+            }
+        }
+        gpuMs /= FILTER_BENCH_FRAMES;
+        wallMs /= FILTER_BENCH_FRAMES;
+        if (m == 0)
+            baseMs = wallMs;
+        char gpuText[16];
+        snprintf(gpuText, sizeof(gpuText), useQuery ? "%.3f" : "-", gpuMs);
+        printf("  %-10s %-11.3f %s (%.0f%% czasu bez mipmap)\n", gpuText, wallMs, modes[m].name,
+               baseMs > 0.0 ? wallMs / baseMs * 100.0 : 100.0);
+    }
+    if (useQuery)
+        glDeleteQueries(1, &query);
+    glDeleteTextures(1, &texture);
+}
+
 
 // SEKCJA 8: GŁÓWNA FUNKCJA
 
-int main(void) {
+// Argumenty: --core (kontekst OpenGL 3.3 core profile zamiast 2.0),
+//            --headless [--frames N] (pomiar bez okna), --record plik / --replay plik (ścieżka kamery),
+//            --gpu-times plik (czasy GPU przebiegów i materiałów każdej klatki do CSV przy wyjściu),
+//            --trace plik (strefy CPU w formacie Chrome trace przy wyjściu i pod klawiszem T),
+//            --no-shader-cache (kompilacja shaderów bez zapisanych programów z shader_cache/)
+int main(int argc, char** argv) {
+    const char* gpuTimesFile = NULL;
+    const char* traceFile = NULL;
+    int useShaderCache = 1;
+    int textureBenchSize = 0;
+    int filterBench = 0;
+    int linmathBench = 0;
+    int streamTexturesSize = 0;     // --stream-textures: wymiana tekstur od pierwszej klatki
+    int useTextureArray = 1;
+    int useTextureCompression = 1;
+    int useTextureCache = 1;
+    Headless headless;
+    headlessInit(&headless);
+    CameraPath path;
+    cameraPathInit(&path);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--core") == 0) {
+            coreProfile = 1;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            cameraPathStartRecording(&path, argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!cameraPathLoad(&path, argv[++i]))
+                exit(EXIT_FAILURE);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless.enabled = 1;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headless.frames = atoi(argv[++i]);
+            if (headless.frames < 1) headless.frames = 1;
+        } else if (strcmp(argv[i], "--gpu-times") == 0 && i + 1 < argc) {
+            gpuTimesFile = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--shader-define") == 0 && i + 1 < argc) {
+            // NAZWA albo NAZWA=WARTOŚĆ - w shaderze jak "#define NAZWA WARTOŚĆ"
+            char* define = argv[++i];
+            char* equals = strchr(define, '=');
+            if (equals)
+                *equals = ' ';
+            addShaderDefine(define);
+        } else if (strcmp(argv[i], "--texture-bench") == 0 && i + 1 < argc) {
+            textureBenchSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mipmaps") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "off") == 0) textureFiltering.mode = MIPMAPS_OFF;
+            else if (strcmp(mode, "cpu") == 0) textureFiltering.mode = MIPMAPS_CPU;
+            else if (strcmp(mode, "gpu") == 0) textureFiltering.mode = MIPMAPS_GPU;
+            else textureFiltering.mode = MIPMAPS_AUTO;
+        } else if (strcmp(argv[i], "--bilinear") == 0) {
+            textureFiltering.trilinear = 0;
+        } else if (strcmp(argv[i], "--anisotropy") == 0 && i + 1 < argc) {
+            textureFiltering.anisotropy = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--no-texture-compression") == 0) {
+            useTextureCompression = 0;
+        } else if (strcmp(argv[i], "--no-texture-cache") == 0) {
+            useTextureCache = 0;
+        } else if (strcmp(argv[i], "--no-texture-array") == 0) {
+            useTextureArray = 0;
+        } else if (strcmp(argv[i], "--filter-bench") == 0) {
+            filterBench = 1;
+        } else if (strcmp(argv[i], "--linmath-bench") == 0) {
+            linmathBench = 1;
+        } else if (strcmp(argv[i], "--stream-textures") == 0 && i + 1 < argc) {
+            streamTexturesSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            useShaderCache = 0;
+        } else {
+            fprintf(stderr, "Nieznany argument: %s\n", argv[i]);
+            fprintf(stderr, "Użycie: %s [--core] [--headless [--frames N]] [--record plik | --replay plik] [--gpu-times plik] [--trace plik] [--no-shader-cache] [--shader-define NAZWA[=WARTOŚĆ]] [--texture-bench ROZMIAR] [--mipmaps off|cpu|gpu|auto] [--bilinear] [--anisotropy N] [--filter-bench] [--linmath-bench] [--no-texture-array] [--no-texture-compression] [--no-texture-cache] [--stream-textures ROZMIAR]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+#ifdef _DEBUG
+    checkViewMatrix();
+#endif
+
     AppState app;
     initAppState(&app);
     
     glfwSetErrorCallback(error_callback);
+    headlessPrepareGlfw(&headless);
+    // Sam pomiar syntezy tekstur - bez okna i OpenGL
+    if (textureBenchSize > 0) {
+        ThreadPool benchWorkers;
+        threadPoolInit(&benchWorkers, -1);
+        int ok = texSynthBenchmark(&benchWorkers, textureBenchSize, 5);
+        threadPoolFree(&benchWorkers);
+        exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    // Sam pomiar linmath.h (pętle skalarne kontra SIMD) na milionie macierzy - też bez okna
+    if (linmathBench)
+        exit(linmathBenchmark(1000000, 5) ? EXIT_SUCCESS : EXIT_FAILURE);
+    
     if (!glfwInit())
         exit(EXIT_FAILURE);
     
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    if (coreProfile) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+    } else {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    }
+    headlessWindowHints(&headless);
     
     GLFWwindow* window = glfwCreateWindow(1024, 768, "Oswietlenie i Teksturowanie", NULL, NULL);
     if (!window) {
@@ -500,67 +1764,251 @@ int main(void) {
     
     glfwMakeContextCurrent(window);
     gladLoadGL();
-    glfwSwapInterval(1);
+    glfwSwapInterval(headless.enabled ? 0 : 1); // Bez vsync w trybie pomiarowym
+    headlessCreateTarget(&headless);
     
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    // Ładowanie shaderów z plików - zgodnie z wymaganiami (5 shaderów vertex + 5 fragment)
-    GLuint programs[5];
-    programs[0] = createShaderProgram("shaders/diffuse.vert", "shaders/diffuse.frag");      // Diffuse
-    programs[1] = createShaderProgram("shaders/specular.vert", "shaders/specular.frag");    // Specular
-    programs[2] = createShaderProgram("shaders/blinn_phong.vert", "shaders/blinn_phong.frag"); // Blinn-Phong
-    programs[3] = createShaderProgram("shaders/texture.vert", "shaders/texture.frag");      // Texture
-    programs[4] = createShaderProgram("shaders/flag.vert", "shaders/flag.frag");             // Flag
+    // Tekstury materiałów jako warstwy jednej tablicy - shadery z TEXTURE_ARRAY wybierają warstwę uniformem
+    useTextureArray = useTextureArray && textureArraysSupported();
+    if (useTextureArray)
+        addShaderDefine("TEXTURE_ARRAY");
     
+    // Ładowanie shaderów z plików - zgodnie z wymaganiami (5 shaderów vertex + 5 fragment)
+    static const char* shaderFiles[5][2] = {
+        { "shaders/diffuse.vert", "shaders/diffuse.frag" },         // Diffuse
+        { "shaders/specular.vert", "shaders/specular.frag" },       // Specular
+        { "shaders/blinn_phong.vert", "shaders/blinn_phong.frag" }, // Blinn-Phong
+        { "shaders/texture.vert", "shaders/texture.frag" },         // Texture
+        { "shaders/flag.vert", "shaders/flag.frag" },               // Flag
+    };
+    // Wszystkie programy są najpierw tylko zlecane - sterownik kompiluje je, gdy my tworzymy tekstury i siatki
+    assetPoolInit(&assetPool);
+    programCacheInit(&shaderCache, "shader_cache", useShaderCache);
+    initShaderCompiler();
+    // Bez GL_KHR_parallel_shader_compile przeładowania budowane są na wątku ze współdzielonym kontekstem
+    ShaderBuilder builder;
+    if (!parallelShaderCompile && shaderBuilderInit(&builder, window))
+        shaderBuilder = &builder;
+    double shaderStart = glfwGetTime();
+    ShaderProgram programs[5];
+    // Zapisane zmiany w shaders/ (także w plikach dołączanych przez #include) są przeładowywane w trakcie działania
+    static ShaderReload reloads[5];
     for (int i = 0; i < 5; i++) {
-        if (!programs[i]) {
+        if (!submitShaderProgram(&programs[i], shaderFiles[i][0], shaderFiles[i][1], &reloads[i].deps, NULL)) {
             fprintf(stderr, "Błąd ładowania shaderów!\n");
             exit(EXIT_FAILURE);
         }
     }
+    int shadersPending = 1;
+    FileWatch shaderWatch;
+    fileWatchInit(&shaderWatch, "shaders");
+    for (int i = 0; i < 5; i++)
+        watchShaderDependencies(&shaderWatch, &reloads[i].deps);
+    printf("Shadery: %d programów zleconych w %.1f ms (z pamięci podręcznej: %d, kompilacja równoległa: %s)\n", 5,
+           (glfwGetTime() - shaderStart) * 1000.0, shaderCache.hits, parallelShaderCompile ? "tak" : "nie");
+    
+    // Wątki robocze do syntezy tekstur (wątek główny też pracuje, czekając na wynik)
+    ThreadPool workers;
+    threadPoolInit(&workers, -1);
     
     // Tworzenie różnych tekstur dla różnych obiektów
     GLuint textures[5];
-    textures[0] = createProceduralTexture(256, 256, 0); // Szachownica czarno-biała
-    textures[1] = createProceduralTexture(256, 256, 1); // Czerwono-niebieska
-    textures[2] = createProceduralTexture(256, 256, 2); // Zielono-żółta
-    textures[3] = createProceduralTexture(256, 256, 3); // Niebiesko-fioletowa
-    textures[4] = createProceduralTexture(256, 256, 4); // Pomarańczowo-różowa
-    
-    // Żółta tekstura dla słońca
-    GLuint yellowTexture = createYellowTexture(256, 256);
-    
-    // Bufor wierzchołków dla sześcianu
-    GLuint cubeVBO;
-    glGenBuffers(1, &cubeVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    
-    // Bufor wierzchołków dla płaszczyzny (flaga)
-    GLuint planeVBO;
-    glGenBuffers(1, &planeVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
+    // (szachownice: czarno-biała, czerwono-niebieska, zielono-żółta, niebiesko-fioletowa, pomarańczowo-różowa)
+    // i żółta tekstura dla słońca
+    GLuint patternTextures[PATTERN_COUNT];
+    static const char* mipmapModeNames[] = { "bez mipmap", "mipmapy CPU", "mipmapy GPU" };
+    textureFiltering.mode = mipResolveMode(textureFiltering.mode);
+    // Tekstury w BC1 - 6x mniej pamięci; zakodowane łańcuchy zapisywane w texture_cache/
+    TextureCache textureCache;
+    useTextureCompression = useTextureCompression && textureCompressionSupported();
+    textureCacheInit(&textureCache, "texture_cache", useTextureCompression && useTextureCache);
+    if (useTextureCompression && textureFiltering.mode == MIPMAPS_GPU)
+        textureFiltering.mode = MIPMAPS_CPU;    // poziomy skompresowanych tekstur koduje się z mipmap z CPU
+    double textureStart = glfwGetTime();
+    size_t textureBytes = createProceduralTextures(&workers, 256, 256, patternTextures, PATTERN_COUNT, useTextureArray,
+                                                   useTextureCompression ? &textureCache : NULL);
+    printf("Tekstury: %d x 256x256 w %.2f ms (wątków: %d, %s, %s, %s, anizotropia %.0f)\n", PATTERN_COUNT,
+           (glfwGetTime() - textureStart) * 1000.0, workers.numWorkers + 1,
+           useTextureArray ? "tablica tekstur" : "osobne tekstury", mipmapModeNames[textureFiltering.mode],
+           textureFiltering.trilinear ? "trójliniowe" : "dwuliniowe",
+           textureFiltering.anisotropy < mipMaxAnisotropy() ? textureFiltering.anisotropy : mipMaxAnisotropy());
+    if (useTextureCompression)
+        printf("Tekstury: %.0f KB w BC1 (z pamięci podręcznej: %d z %d)\n", textureBytes / 1024.0, textureCache.hits,
+               PATTERN_COUNT);
+    else
+        printf("Tekstury: %.0f KB w RGB bez kompresji\n", textureBytes / 1024.0);
+    for (int i = 0; i < 5; i++)
+        textures[i] = patternTextures[i];
+    GLuint yellowTexture = patternTextures[PATTERN_YELLOW];
+    
+    // Pierścień buforów PBO do wymiany tekstur w trakcie działania (klawisz H) - 4 x 2 MB
+    TexStream textureStream;
+    texStreamInit(&textureStream, 2 * 1024 * 1024);
+    TextureSwap textureSwap;
+    textureSwap.active = 0;
+    textureSwap.settleFrames = 0;
+    int textureSwapSize = streamTexturesSize > 0 ? streamTexturesSize : 1024;
+    app.streamRequested = streamTexturesSize > 0;
+    
+    // Nakładka ze statystykami - shadery w GLSL 110 jak pliki z shaders/
+    Overlay overlay;
+    if (!overlayInit(&overlay, coreProfile ? coreVertexHeader : "#version 110\n",
+                     coreProfile ? coreFragmentHeader : "#version 110\n"))
+        fprintf(stderr, "Nie udało się utworzyć nakładki - klawisz O nie będzie działał\n");
+    
+    // Siatka sześcianu
+    Mesh cubeMesh;
+    createMesh(&cubeMesh, cubeVertices, sizeof(cubeVertices) / sizeof(cubeVertices[0]));
+    
+    // Siatka płaszczyzny (flaga)
+    Mesh planeMesh;
+    createMesh(&planeMesh, planeVertices, sizeof(planeVertices) / sizeof(planeVertices[0]));
+    // flag.vert przesuwa wierzchołki w Y o +-0.1 - powiększamy sferę o amplitudę fali
+    planeMesh.boundsMax[1] += 0.1f;
+    planeMesh.boundsMin[1] -= 0.1f;
+    planeMesh.boundsRadius += 0.1f;
+    
+    // Sam pomiar filtrowania tekstur w oddali - programem tekstury (bez oświetlenia) na siatce płaszczyzny
+    if (filterBench) {
+        int width, height;
+        headlessFramebufferSize(&headless, window, &width, &height);
+        runFilterBenchmark(&workers, &programs[3], &planeMesh, useTextureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D,
+                           width, height);
+        glfwTerminate();
+        exit(EXIT_SUCCESS);
+    }
+    
+    GpuTimer gpuTimer;
+    gpuTimerInit(&gpuTimer, gpuZoneNames, GPU_ZONE_COUNT);
+    
+    RenderQueue queue;
+    initRenderQueue(&queue, programs, 5);
+    queue.timer = &gpuTimer;
+    queue.textureTarget = useTextureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    
+    // Drzewo BVH nad prostopadłościanami obiektów - obcinanie i wybieranie klawiszem P
+    vec3 boxMin[5], boxMax[5];
+    int visibleIndices[5];
+    for (int i = 0; i < app.numObjects; i++) {
+        const Mesh* mesh = app.objects[i].materialType == 4 ? &planeMesh : &cubeMesh;
+        vec3_add(boxMin[i], mesh->boundsMin, app.objects[i].position);
+        vec3_add(boxMax[i], mesh->boundsMax, app.objects[i].position);
+    }
+    Bvh bvh;
+    bvhInit(&bvh);
+    if (!bvhBuild(&bvh, boxMin, boxMax, app.numObjects)) {
+        fprintf(stderr, "Brak pamięci na drzewo BVH\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    // Transformacje obiektów do wsadowego liczenia M i MVP; ostatnia pozycja to kostka światła
+    const int lightTransform = app.numObjects;
+    TransformSet transforms;
+    transformSetInit(&transforms);
+    if (!transformSetResize(&transforms, app.numObjects + 1)) {
+        fprintf(stderr, "Brak pamięci na transformacje obiektów\n");
+        exit(EXIT_FAILURE);
+    }
+    quat noRotation;
+    quat_identity(noRotation);
+    vec3 unitScale = { 1.0f, 1.0f, 1.0f };
+    vec3 lightScale = { 0.2f, 0.2f, 0.2f }; // Mała kostka
+    for (int i = 0; i < app.numObjects; i++)
+        transformSetObject(&transforms, i, app.objects[i].position, noRotation, unitScale);
+    transformSetObject(&transforms, lightTransform, app.light.position, noRotation, lightScale);
+    int drawIndices[6];
+    mat4x4 drawM[6], drawMVP[6];
     
     double lastTime = glfwGetTime();
+    double statsTime = lastTime;
+    int frameCount = 0;
+    float cpuMsAverage = 0.0f;
     
+    profilerInit();
     while (!glfwWindowShouldClose(window)) {
+        profilerBegin("klatka");
         double currentTime = glfwGetTime();
         float deltaTime = (float)(currentTime - lastTime);
         lastTime = currentTime;
+        overlayAddFrameTime(&overlay, deltaTime * 1000.0f);
+        
+        // Programy, które sterownik już skończył, przechodzą do gotowych bez czekania
+        if (shadersPending) {
+            shadersPending = 0;
+            for (int i = 0; i < 5; i++) {
+                int state = pollShaderProgram(&programs[i]);
+                if (state < 0) {
+                    fprintf(stderr, "Błąd ładowania shaderów!\n");
+                    exit(EXIT_FAILURE);
+                }
+                shadersPending |= state == 0;
+            }
+            if (!shadersPending)
+                printf("Shadery gotowe po %.1f ms od zlecenia\n", (glfwGetTime() - shaderStart) * 1000.0);
+        }
+        
+        // Zmienione pliki shaderów - nowe wersje budują się w tle, stare rysują do czasu podmiany
+        char changedFiles[10][FILE_WATCH_NAME_MAX];
+        int numChanged = fileWatchPoll(&shaderWatch, currentTime, changedFiles, 10);
+        for (int i = 0; i < 5; i++) {
+            int changed = 0;
+            for (int d = 0; d < reloads[i].deps.count && !changed; d++) {
+                const char* name = fileWatchName(&shaderWatch, reloads[i].deps.files[d]);
+                for (int c = 0; c < numChanged && name; c++)
+                    changed |= strcmp(name, changedFiles[c]) == 0;
+            }
+            if (changed) {
+                startShaderReload(&reloads[i], shaderFiles[i][0], shaderFiles[i][1]);
+                watchShaderDependencies(&shaderWatch, &reloads[i].deps);    // np. nowy #include
+            }
+            updateShaderReload(&reloads[i], &programs[i]);
+        }
+        
+        // Strumień tekstur - paski gotowe w buforach idą do tekstur, nowe paski do wątków; bez czekania
+        if (app.streamRequested) {
+            app.streamRequested = 0;
+            if (startTextureSwap(&textureSwap, &textureStream, textureSwapSize, useTextureArray))
+                printf("Wymiana tekstur na %dx%d przez PBO (%s)\n", textureSwapSize, textureSwapSize,
+                       textureStream.persistent ? "bufory zmapowane na stałe" : "mapowanie co pasek");
+        }
+        texStreamUpdate(&textureStream, &workers);
+        if (updateTextureSwap(&textureSwap, deltaTime * 1000.0f, patternTextures)) {
+            for (int i = 0; i < 5; i++)
+                textures[i] = patternTextures[i];
+            yellowTexture = patternTextures[PATTERN_YELLOW];
+        }
+        
+        // Odtwarzanie nagranej ścieżki - kamera i światło z pliku, stały krok czasu zamiast zegara
+        if (path.mode == PATH_REPLAY) {
+            CameraPathFrame pathFrame;
+            if (!cameraPathNext(&path, &pathFrame)) {
+                profilerEnd();
+                break;
+            }
+            applyPathFrame(&app, &pathFrame);
+            deltaTime = path.timestep;
+        }
+        
+        headlessBeginFrame(&headless);
+        gpuTimerBeginFrame(&gpuTimer);
+        gpuTimerBegin(&gpuTimer, GPU_ZONE_FRAME);
         
         int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        headlessFramebufferSize(&headless, window, &width, &height);
         float ratio = width / (float)height;
         
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         // Aktualizacja pozycji kamery lub światła
-        if (app.controlMode == 0) { // Tryb kamery
+        profilerBegin("wejscie");
+        if (path.mode == PATH_REPLAY) {
+            // Przy odtwarzaniu wszystko ustawia nagranie - klawisze są ignorowane
+        } else if (app.controlMode == 0) { // Tryb kamery
             vec3 forward, right;
             getCameraForward(forward, &app.camera);
             getCameraRight(right, &app.camera);
@@ -594,141 +2042,181 @@ int main(void) {
             if (app.keyC) app.light.position[1] -= app.moveSpeed * deltaTime; // -Y
         }
         
+        if (path.mode == PATH_RECORD) {
+            CameraPathFrame pathFrame;
+            capturePathFrame(&app, &pathFrame);
+            cameraPathRecord(&path, &pathFrame);
+        }
+        profilerEnd();
+        
         // Macierze
-        mat4x4 P, V, M, MVP;
+        profilerBegin("kamera");
+        mat4x4 P, V;
         float fov_rad = app.fov * (float)M_PI / 180.0f;
         mat4x4_perspective(P, fov_rad, ratio, 0.1f, 100.0f);
         calculateViewMatrix(V, &app.camera);
         
-        // Renderowanie 5 obiektów - każdy z innym materiałem
-        for (int i = 0; i < app.numObjects; i++) {
+        FrameUniforms frame;
+        mat4x4_dup(frame.V, V);
+        vec3_dup(frame.lightPos, app.light.position);
+        vec3_dup(frame.lightColor, app.light.color);
+        vec3_dup(frame.viewPos, app.camera.position);
+        // Dla animacji flagi; przy odtwarzaniu czas symulowany, żeby klatki były powtarzalne
+        frame.time = path.mode == PATH_REPLAY ? path.cursor * path.timestep : (float)glfwGetTime();
+        profilerEnd();
+        
+        profilerBegin("obcinanie");
+        // Obcinanie - do kolejki trafiają tylko obiekty przecinające bryłę widzenia
+        mat4x4 PV;
+        Frustum frustum;
+        mat4x4_mul(PV, P, V);
+        frustumFromMatrix(&frustum, PV);
+        int visibleCount = bvhCullFrustum(&bvh, &frustum, visibleIndices);
+        profilerEnd();
+        
+        // Wybieranie obiektu - promień z kamery wzdłuż kierunku patrzenia
+        if (app.pickRequested) {
+            static const char* materialNames[5] = { "diffuse", "specular", "blinn-phong", "texture", "flag" };
+            vec3 forward;
+            float hitT = 0.0f;
+            getCameraForward(forward, &app.camera);
+            double pickStart = glfwGetTime();
+            int hit = bvhRaycast(&bvh, app.camera.position, forward, 100.0f, &hitT);
+            double pickMs = (glfwGetTime() - pickStart) * 1000.0;
+            if (hit >= 0)
+                printf("Wybrano obiekt %d - %s (odległość %.2f, zapytanie %.4f ms)\n",
+                       hit, materialNames[app.objects[hit].materialType], hitT, pickMs);
+            else
+                printf("Nic nie trafiono (zapytanie %.4f ms)\n", pickMs);
+            app.pickRequested = 0;
+        }
+        
+        // Macierze M i MVP widocznych obiektów i kostki światła - jednym przebiegiem
+        profilerBegin("macierze");
+        for (int v = 0; v < visibleCount; v++)
+            drawIndices[v] = visibleIndices[v];
+        drawIndices[visibleCount] = lightTransform;
+        transformSetPosition(&transforms, lightTransform, app.light.position);
+        transformCompute(&transforms, drawIndices, visibleCount + 1, PV, drawMVP, drawM, NULL);
+        profilerEnd();
+        
+        // Zgłaszanie obiektów do kolejki - każdy z innym materiałem
+        profilerBegin("kolejka");
+        for (int v = 0; v < visibleCount; v++) {
+            const SceneObject* object = &app.objects[visibleIndices[v]];
+            DrawPacket* packet = submitDraw(&queue);
             // Wybieramy odpowiedni shader w zależności od typu materiału
-            GLuint program = programs[app.objects[i].materialType];
-            glUseProgram(program);
-            
-            mat4x4_identity(M);
-            mat4x4_translate_in_place(M, app.objects[i].position[0], 
-                                         app.objects[i].position[1], 
-                                         app.objects[i].position[2]);
-            mat4x4_mul(MVP, V, M);
-            mat4x4_mul(MVP, P, MVP);
+            packet->programIndex = object->materialType;
+            packet->layer = LAYER_OPAQUE;
             
-            // Pobieramy lokalizacje uniformów i przekazujemy dane do shaderów
-            GLint mvpLoc = glGetUniformLocation(program, "MVP");
-            GLint mLoc = glGetUniformLocation(program, "M");
-            GLint vLoc = glGetUniformLocation(program, "V");
-            GLint lightPosLoc = glGetUniformLocation(program, "lightPos");      // Pozycja światła punktowego
-            GLint lightColorLoc = glGetUniformLocation(program, "lightColor");
-            GLint viewPosLoc = glGetUniformLocation(program, "viewPos");
-            GLint timeLoc = glGetUniformLocation(program, "time");              // Dla animacji flagi
-            GLint texLoc = glGetUniformLocation(program, "textureSampler");
-            GLint objectColorLoc = glGetUniformLocation(program, "objectColor");  // Kolor obiektu
-            
-            // Przekazujemy macierze i parametry do shaderów
-            if (mvpLoc >= 0) glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, (const GLfloat*)MVP);
-            if (mLoc >= 0) glUniformMatrix4fv(mLoc, 1, GL_FALSE, (const GLfloat*)M);
-            if (vLoc >= 0) glUniformMatrix4fv(vLoc, 1, GL_FALSE, (const GLfloat*)V);
-            if (lightPosLoc >= 0) glUniform3fv(lightPosLoc, 1, app.light.position);
-            if (lightColorLoc >= 0) glUniform3fv(lightColorLoc, 1, app.light.color);
-            if (viewPosLoc >= 0) glUniform3fv(viewPosLoc, 1, app.camera.position);
-            if (timeLoc >= 0) glUniform1f(timeLoc, (float)glfwGetTime());
-            if (objectColorLoc >= 0) glUniform3fv(objectColorLoc, 1, app.objects[i].color);
+            mat4x4_dup(packet->M, drawM[v]);
+            mat4x4_dup(packet->MVP, drawMVP[v]);
+            vec3_dup(packet->color, object->color);
             
             // Dla obiektów z teksturami (texture i flag) ustawiamy odpowiednią teksturę
-            if (app.objects[i].materialType == 3 || app.objects[i].materialType == 4) {
-                glActiveTexture(GL_TEXTURE0);
-                int texIdx = app.objects[i].textureIndex;
-                if (texIdx >= 0 && texIdx < 5) {
-                    glBindTexture(GL_TEXTURE_2D, textures[texIdx]);
-                } else {
-                    glBindTexture(GL_TEXTURE_2D, textures[0]);
-                }
-                if (texLoc >= 0) glUniform1i(texLoc, 0);
-            }
-            
-            GLint vposLoc = glGetAttribLocation(program, "vPos");
-            GLint vnormalLoc = glGetAttribLocation(program, "vNormal");
-            GLint vcolLoc = glGetAttribLocation(program, "vCol");
-            GLint vtexLoc = glGetAttribLocation(program, "vTexCoord");
-            
-            if (app.objects[i].materialType == 4) { // Flaga - użyj płaszczyzny
-                glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-            } else {
-                glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-            }
-            
-            if (vposLoc >= 0) {
-                glEnableVertexAttribArray(vposLoc);
-                glVertexAttribPointer(vposLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-            }
-            if (vnormalLoc >= 0) {
-                glEnableVertexAttribArray(vnormalLoc);
-                glVertexAttribPointer(vnormalLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 3));
-            }
-            if (vcolLoc >= 0) {
-                glEnableVertexAttribArray(vcolLoc);
-                glVertexAttribPointer(vcolLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 6));
-            }
-            if (vtexLoc >= 0) {
-                glEnableVertexAttribArray(vtexLoc);
-                glVertexAttribPointer(vtexLoc, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 9));
+            if (object->materialType == 3 || object->materialType == 4) {
+                int texIdx = (object->textureIndex >= 0 && object->textureIndex < 5) ? object->textureIndex : 0;
+                packet->texture = textures[texIdx];
+                packet->textureLayer = (float)texIdx;     // przy tablicy tekstur sama warstwa się zmienia
             }
             
-            if (app.objects[i].materialType == 4) {
-                glDrawArrays(GL_TRIANGLES, 0, 6);
-            } else {
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+            // Flaga używa płaszczyzny, pozostałe obiekty sześcianu
+            packet->mesh = object->materialType == 4 ? &planeMesh : &cubeMesh;
         }
         
         // Wizualizacja światła punktowego jako kostki 
         // Używamy żółtej tekstury żeby wyglądało jak słońce
-        glUseProgram(programs[3]);
-        mat4x4_identity(M);
-        mat4x4_translate_in_place(M, app.light.position[0], app.light.position[1], app.light.position[2]);
-        mat4x4_scale_aniso(M, M, 0.2f, 0.2f, 0.2f); // Mała kostka
-        mat4x4_mul(MVP, V, M);
-        mat4x4_mul(MVP, P, MVP);
-        
-        GLint mvpLoc = glGetUniformLocation(programs[3], "MVP");
-        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, (const GLfloat*)MVP);
-        
-        // Żółta tekstura dla światła
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, yellowTexture);
-        GLint texLoc = glGetUniformLocation(programs[3], "textureSampler");
-        if (texLoc >= 0) glUniform1i(texLoc, 0);
+        DrawPacket* lightPacket = submitDraw(&queue);
+        lightPacket->programIndex = 3;
+        lightPacket->texture = yellowTexture;
+        lightPacket->textureLayer = (float)PATTERN_YELLOW;
+        lightPacket->mesh = &cubeMesh;
+        // Wyłączamy depth test żeby światło było zawsze widoczne
+        lightPacket->layer = LAYER_NO_DEPTH;
+        mat4x4_dup(lightPacket->M, drawM[visibleCount]);
+        mat4x4_dup(lightPacket->MVP, drawMVP[visibleCount]);
+        profilerEnd();
         
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        GLint vposLoc = glGetAttribLocation(programs[3], "vPos");
-        GLint vtexLoc = glGetAttribLocation(programs[3], "vTexCoord");
+        flushRenderQueue(&queue, &frame);
         
-        if (vposLoc >= 0) {
-            glEnableVertexAttribArray(vposLoc);
-            glVertexAttribPointer(vposLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        }
-        if (vtexLoc >= 0) {
-            glEnableVertexAttribArray(vtexLoc);
-            glVertexAttribPointer(vtexLoc, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 9));
+        // Nakładka - czas CPU klatki do tej chwili (bez czekania na vsync w glfwSwapBuffers)
+        float cpuMs = (float)((glfwGetTime() - currentTime) * 1000.0);
+        cpuMsAverage = cpuMsAverage * 0.95f + cpuMs * 0.05f;
+        if (app.showOverlay) {
+            profilerBegin("nakladka");
+            drawStatsOverlay(&overlay, width, height, cpuMsAverage, gpuTimerAverage(&gpuTimer, GPU_ZONE_FRAME),
+                             &queue.stats, app.numObjects - visibleCount);
+            profilerEnd();
         }
+        gpuTimerEnd(&gpuTimer, GPU_ZONE_FRAME);
         
-        // Wyłączamy depth test żeby światło było zawsze widoczne
-        glDisable(GL_DEPTH_TEST);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glEnable(GL_DEPTH_TEST);
+        // Raz na sekundę pokazujemy liczniki zmian stanu w tytule okna
+        frameCount++;
+        if (currentTime - statsTime >= 1.0) {
+            const RenderStats* st = &queue.stats;
+            char title[256];
+            snprintf(title, sizeof(title),
+                     "Oswietlenie i Teksturowanie | %.0f FPS | GPU: %.3f ms | widoczne: %d, odrzucone: %d | rysowania: %d | "
+                     "zmiany programu: %d (pominiete %d), tekstury: %d (%d), siatki: %d (%d)",
+                     frameCount / (currentTime - statsTime), gpuTimerAverage(&gpuTimer, GPU_ZONE_FRAME), visibleCount, app.numObjects - visibleCount, st->draws,
+                     st->programChanges, st->programChangesSkipped,
+                     st->textureChanges, st->textureChangesSkipped,
+                     st->meshChanges, st->meshChangesSkipped);
+            glfwSetWindowTitle(window, title);
+            frameCount = 0;
+            statsTime = currentTime;
+        }
         
+        profilerBegin("glfwSwapBuffers");
         glfwSwapBuffers(window);
+        profilerEnd();
+        profilerBegin("glfwPollEvents");
         glfwPollEvents();
+        profilerEnd();
+        headlessEndFrame(&headless, window);
+        if (path.mode == PATH_REPLAY)
+            cameraPathFrameDone(&path, glfwGetTime());
+        profilerEnd();
+        
+        // Zapis stref na żądanie - np. zaraz po zauważonym przycięciu
+        if (app.traceRequested) {
+            app.traceRequested = 0;
+            profilerWriteTrace(traceFile ? traceFile : "trace.json");
+        }
     }
+    if (traceFile)
+        profilerWriteTrace(traceFile);
+    headlessReport(&headless);
+    if (path.mode == PATH_RECORD)
+        cameraPathSave(&path);
+    cameraPathReport(&path);
+    cameraPathFree(&path);
+    if (gpuTimesFile)
+        gpuTimerWriteCsv(&gpuTimer, gpuTimesFile);
     
     // Czyszczenie
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteBuffers(1, &planeVBO);
+    overlayFree(&overlay);
+    gpuTimerFree(&gpuTimer);
+    destroyRenderQueue(&queue);
+    bvhFree(&bvh);
+    transformSetFree(&transforms);
+    destroyMesh(&cubeMesh);
+    destroyMesh(&planeMesh);
+    fileWatchFree(&shaderWatch);
+    assetPoolFree(&assetPool);
+    if (shaderBuilder)
+        shaderBuilderFree(shaderBuilder);
     for (int i = 0; i < 5; i++) {
-        glDeleteTextures(1, &textures[i]);
-        glDeleteProgram(programs[i]);
+        if (reloads[i].job.queued)
+            collectShaderBuild(&reloads[i].job, &reloads[i].program);
+        discardShaderProgram(&reloads[i].program);
+        discardShaderProgram(&programs[i]);
     }
-    glDeleteTextures(1, &yellowTexture);
+    // Przy tablicy tekstur wszystkie nazwy są tą samą teksturą - ponowne usunięcie jest pomijane przez OpenGL
+    glDeleteTextures(PATTERN_COUNT, patternTextures);
+    texStreamFree(&textureStream, &workers);
+    freeTextureSwap(&textureSwap);
+    threadPoolFree(&workers);
     
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -0,0 +1,149 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+// Łańcuch mipmap dla tekstur RGB i ustawienia próbkowania (trójliniowe, anizotropowe).
+// Poziomy liczone na CPU filtrem pudełkowym 2x2 (dla nieparzystych rozmiarów ostatni wiersz /
+// kolumna jest powielany), każdy poziom z poprzedniego, wiersze poziomu dzielone między wątki puli.
+// Alternatywnie glGenerateMipmap (OpenGL 3.0 / GL_ARB_framebuffer_object) - liczy sterownik.
+// Wymaga wcześniejszego dołączenia glad.h, threadpool.h i profiler.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIP_MAX_LEVELS 16           // do 32768 x 32768
+#define MIP_ROWS_PER_CHUNK 16
+
+enum MipmapMode {
+    MIPMAPS_OFF,    // tylko poziom 0, filtr GL_LINEAR jak dotychczas
+    MIPMAPS_CPU,
+    MIPMAPS_GPU,
+    MIPMAPS_AUTO    // GPU, jeśli sterownik ma glGenerateMipmap, w przeciwnym razie CPU
+};
+
+typedef struct {
+    int mode;               // MipmapMode
+    int trilinear;          // 1 = GL_LINEAR_MIPMAP_LINEAR, 0 = GL_LINEAR_MIPMAP_NEAREST
+    float anisotropy;       // 1 = wyłączone; przycinane do maksimum sterownika
+} TextureFiltering;
+
+typedef struct {
+    int levels;
+    int width[MIP_MAX_LEVELS], height[MIP_MAX_LEVELS];
+    size_t offset[MIP_MAX_LEVELS];  // początek poziomu w pixels
+    unsigned char* pixels;          // wszystkie poziomy RGB jeden za drugim
+} MipChain;
+
+static inline int mipLevelCount(int width, int height) {
+    int levels = 1;
+    while ((width > 1 || height > 1) && levels < MIP_MAX_LEVELS) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+static inline int mipGenerateSupported(void) {
+    return GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_framebuffer_object;
+}
+
+// Maksymalna anizotropia sterownika; 1 gdy brak rozszerzenia
+static inline float mipMaxAnisotropy(void) {
+    if (!GLAD_GL_ARB_texture_filter_anisotropic && !GLAD_GL_EXT_texture_filter_anisotropic)
+        return 1.0f;
+    GLfloat maxAnisotropy = 1.0f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+    return maxAnisotropy;
+}
+
+// Tryb AUTO zamieniony na to, co obsługuje sterownik (po załadowaniu funkcji GL)
+static inline int mipResolveMode(int mode) {
+    if (mode == MIPMAPS_AUTO)
+        return mipGenerateSupported() ? MIPMAPS_GPU : MIPMAPS_CPU;
+    if (mode == MIPMAPS_GPU && !mipGenerateSupported()) {
+        fprintf(stderr, "Brak glGenerateMipmap - mipmapy liczone na CPU\n");
+        return MIPMAPS_CPU;
+    }
+    return mode;
+}
+
+// Układ poziomów i bufor na cały łańcuch (mipmaps = 0 - tylko poziom 0);
+// poziom 0 do wypełnienia przez wywołującego
+static inline int mipChainAlloc(MipChain* chain, int width, int height, int mipmaps) {
+    memset(chain, 0, sizeof(*chain));
+    chain->levels = mipmaps ? mipLevelCount(width, height) : 1;
+    size_t offset = 0;
+    for (int level = 0; level < chain->levels; level++) {
+        chain->width[level] = width;
+        chain->height[level] = height;
+        chain->offset[level] = offset;
+        offset += (size_t)width * height * 3;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    chain->pixels = (unsigned char*)malloc(offset);
+    return chain->pixels != NULL;
+}
+
+// Bajty wszystkich poziomów łańcucha
+static inline size_t mipChainBytes(const MipChain* chain) {
+    int last = chain->levels - 1;
+    return chain->offset[last] + (size_t)chain->width[last] * chain->height[last] * 3;
+}
+
+static inline void mipChainFree(MipChain* chain) {
+    free(chain->pixels);
+    chain->pixels = NULL;
+}
+
+typedef struct {
+    const MipChain* chain;
+    int level;              // liczony poziom (źródło: level - 1)
+} MipDownsample;
+
+static inline void mipDownsampleRows(void* arg, int begin, int end) {
+    const MipDownsample* job = (const MipDownsample*)arg;
+    const MipChain* chain = job->chain;
+    int srcWidth = chain->width[job->level - 1], srcHeight = chain->height[job->level - 1];
+    int width = chain->width[job->level];
+    const unsigned char* src = chain->pixels + chain->offset[job->level - 1];
+    unsigned char* dst = chain->pixels + chain->offset[job->level];
+    profilerBegin("mipmapy");
+    for (int y = begin; y < end; y++) {
+        const unsigned char* row0 = src + (size_t)(2 * y < srcHeight ? 2 * y : srcHeight - 1) * srcWidth * 3;
+        const unsigned char* row1 = src + (size_t)(2 * y + 1 < srcHeight ? 2 * y + 1 : srcHeight - 1) * srcWidth * 3;
+        unsigned char* out = dst + (size_t)y * width * 3;
+        for (int x = 0; x < width; x++) {
+            int x0 = 2 * x < srcWidth ? 2 * x : srcWidth - 1;
+            int x1 = 2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1;
+            for (int c = 0; c < 3; c++)
+                out[x * 3 + c] = (unsigned char)((row0[x0 * 3 + c] + row0[x1 * 3 + c] + row1[x0 * 3 + c] + row1[x1 * 3 + c] + 2) >> 2);
+        }
+    }
+    profilerEnd();
+}
+
+// Poziomy 1..levels-1 z poziomu 0; każdy poziom czeka na poprzedni, wiersze poziomu równolegle
+static inline void mipChainBuild(MipChain* chain, ThreadPool* pool) {
+    for (int level = 1; level < chain->levels; level++) {
+        MipDownsample job = { chain, level };
+        threadPoolFor(pool, mipDownsampleRows, &job, chain->height[level], MIP_ROWS_PER_CHUNK);
+    }
+}
+
+// Ustawienia próbkowania tekstury podpiętej pod target
+static inline void mipApplyFiltering(GLenum target, const TextureFiltering* filtering, int hasMipmaps) {
+    GLint minFilter = GL_LINEAR;
+    if (hasMipmaps)
+        minFilter = filtering->trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    float maxAnisotropy = mipMaxAnisotropy();
+    if (maxAnisotropy > 1.0f) {
+        float anisotropy = filtering->anisotropy < maxAnisotropy ? filtering->anisotropy : maxAnisotropy;
+        glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY, anisotropy > 1.0f ? anisotropy : 1.0f);
+    }
+}
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+// Nakładka ze statystykami wydajności rysowana na obrazie sceny. Tekst i wykres czasu klatki to
+// prostokąty z jednej tekstury (atlas czcionki 5x7 generowany w programie), zbierane w tablicy
+// wierzchołków i wysyłane jednym glBufferData + jednym glDrawArrays na klatkę.
+// Wymaga wcześniejszego dołączenia glad.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define OVERLAY_MAX_QUADS 1024
+#define OVERLAY_GRAPH_FRAMES 128    // klatki na wykresie
+#define OVERLAY_CELL_W 6            // komórka atlasu: znak 5x7 + odstęp
+#define OVERLAY_CELL_H 8
+#define OVERLAY_ATLAS_W 128
+#define OVERLAY_ATLAS_H 64
+#define OVERLAY_SOLID_GLYPH 64      // pełny prostokąt (tło, słupki wykresu)
+
+// Znaki ' ' .. '_' (małe litery rysowane jako wielkie), 5 kolumn po 7 bitów, bit 0 = górny wiersz
+static const unsigned char overlayFont[64][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+};
+
+static const char* overlayVertexSource =
+    "uniform vec2 screenSize;\n"
+    "attribute vec2 vPos;\n"
+    "attribute vec2 vTexCoord;\n"
+    "attribute vec4 vCol;\n"
+    "varying vec2 texCoord;\n"
+    "varying vec4 color;\n"
+    "void main()\n"
+    "{\n"
+    "    texCoord = vTexCoord;\n"
+    "    color = vCol;\n"
+    "    gl_Position = vec4(vPos.x / screenSize.x * 2.0 - 1.0, 1.0 - vPos.y / screenSize.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* overlayFragmentSource =
+    "uniform sampler2D fontTexture;\n"
+    "varying vec2 texCoord;\n"
+    "varying vec4 color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = color * texture2D(fontTexture, texCoord);\n"
+    "}\n";
+
+typedef struct {
+    float x, y;             // piksele, (0, 0) = lewy górny róg
+    float u, v;
+    unsigned char r, g, b, a;
+} OverlayVertex;
+
+typedef struct {
+    GLuint program;
+    GLuint texture;
+    GLuint vbo;
+    GLuint vao;             // 0 gdy brak VAO (kontekst 2.0 bez rozszerzenia)
+    GLint screenSizeLoc, fontTextureLoc;
+    GLint posLoc, texCoordLoc, colorLoc;
+    OverlayVertex* vertices;        // OVERLAY_MAX_QUADS * 6
+    int numVertices;
+    float frameMs[OVERLAY_GRAPH_FRAMES];
+    int graphPos;
+} Overlay;
+
+// Atlas czcionki RGBA: biały znak na przezroczystym tle, jak tekstury proceduralne generowany w pętli
+static inline GLuint createFontTexture(void) {
+    unsigned char* data = (unsigned char*)calloc(OVERLAY_ATLAS_W * OVERLAY_ATLAS_H, 4);
+    if (!data)
+        return 0;
+    for (int glyph = 0; glyph <= OVERLAY_SOLID_GLYPH; glyph++) {
+        int cellX = (glyph % 16) * OVERLAY_CELL_W;
+        int cellY = (glyph / 16) * OVERLAY_CELL_H;
+        for (int y = 0; y < OVERLAY_CELL_H; y++) {
+            for (int x = 0; x < OVERLAY_CELL_W; x++) {
+                int on = glyph == OVERLAY_SOLID_GLYPH ||
+                         (x < 5 && y < 7 && (overlayFont[glyph][x] >> y) & 1);
+                unsigned char* texel = data + ((cellY + y) * OVERLAY_ATLAS_W + cellX + x) * 4;
+                texel[0] = texel[1] = texel[2] = 255;
+                texel[3] = on ? 255 : 0;
+            }
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, OVERLAY_ATLAS_W, OVERLAY_ATLAS_H, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    free(data);
+    return texture;
+}
+
+static inline GLuint overlayCompile(GLenum type, const char* header, const char* body) {
+    const char* sources[2] = { header, body };
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 2, sources, NULL);
+    glCompileShader(shader);
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        fprintf(stderr, "Błąd kompilacji shadera nakładki:\n%s\n", infoLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Nagłówki shaderów jak dla plików z shaders/ ("#version 110\n" albo nagłówki core profile);
+// zwraca 0 gdy nakładki nie da się utworzyć
+static inline int overlayInit(Overlay* overlay, const char* vertexHeader, const char* fragmentHeader) {
+    memset(overlay, 0, sizeof(*overlay));
+    overlay->vertices = (OverlayVertex*)malloc(sizeof(OverlayVertex) * OVERLAY_MAX_QUADS * 6);
+    if (!overlay->vertices)
+        return 0;
+    GLuint vertShader = overlayCompile(GL_VERTEX_SHADER, vertexHeader, overlayVertexSource);
+    GLuint fragShader = overlayCompile(GL_FRAGMENT_SHADER, fragmentHeader, overlayFragmentSource);
+    if (!vertShader || !fragShader) {
+        if (vertShader) glDeleteShader(vertShader);
+        if (fragShader) glDeleteShader(fragShader);
+        return 0;
+    }
+    overlay->program = glCreateProgram();
+    glAttachShader(overlay->program, vertShader);
+    glAttachShader(overlay->program, fragShader);
+    glLinkProgram(overlay->program);
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    GLint success;
+    glGetProgramiv(overlay->program, GL_LINK_STATUS, &success);
+    if (!success) {
+        fprintf(stderr, "Błąd linkowania programu nakładki\n");
+        glDeleteProgram(overlay->program);
+        overlay->program = 0;
+        return 0;
+    }
+    overlay->screenSizeLoc = glGetUniformLocation(overlay->program, "screenSize");
+    overlay->fontTextureLoc = glGetUniformLocation(overlay->program, "fontTexture");
+    overlay->posLoc = glGetAttribLocation(overlay->program, "vPos");
+    overlay->texCoordLoc = glGetAttribLocation(overlay->program, "vTexCoord");
+    overlay->colorLoc = glGetAttribLocation(overlay->program, "vCol");
+
+    overlay->texture = createFontTexture();
+    glGenBuffers(1, &overlay->vbo);
+    if (GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_vertex_array_object) {
+        glGenVertexArrays(1, &overlay->vao);
+        glBindVertexArray(overlay->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, overlay->vbo);
+        glEnableVertexAttribArray(overlay->posLoc);
+        glVertexAttribPointer(overlay->posLoc, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)0);
+        glEnableVertexAttribArray(overlay->texCoordLoc);
+        glVertexAttribPointer(overlay->texCoordLoc, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)(sizeof(float) * 2));
+        glEnableVertexAttribArray(overlay->colorLoc);
+        glVertexAttribPointer(overlay->colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(OverlayVertex), (void*)(sizeof(float) * 4));
+        glBindVertexArray(0);
+    }
+    return 1;
+}
+
+static inline void overlayFree(Overlay* overlay) {
+    if (overlay->vao) glDeleteVertexArrays(1, &overlay->vao);
+    if (overlay->vbo) glDeleteBuffers(1, &overlay->vbo);
+    if (overlay->texture) glDeleteTextures(1, &overlay->texture);
+    if (overlay->program) glDeleteProgram(overlay->program);
+    free(overlay->vertices);
+    overlay->vertices = NULL;
+    overlay->vao = overlay->vbo = overlay->texture = overlay->program = 0;
+}
+
+// Czas klatki na wykres - wywoływane w każdej klatce, także gdy nakładka jest ukryta
+static inline void overlayAddFrameTime(Overlay* overlay, float ms) {
+    overlay->frameMs[overlay->graphPos] = ms;
+    overlay->graphPos = (overlay->graphPos + 1) % OVERLAY_GRAPH_FRAMES;
+}
+
+static inline void overlayBegin(Overlay* overlay) {
+    overlay->numVertices = 0;
+}
+
+// Prostokąt z wycinkiem atlasu dla znaku glyph; color = 0xRRGGBBAA
+static inline void overlayQuad(Overlay* overlay, float x, float y, float w, float h, int glyph, unsigned int color) {
+    if (overlay->numVertices + 6 > OVERLAY_MAX_QUADS * 6)
+        return;
+    float u0 = (float)((glyph % 16) * OVERLAY_CELL_W) / OVERLAY_ATLAS_W;
+    float v0 = (float)((glyph / 16) * OVERLAY_CELL_H) / OVERLAY_ATLAS_H;
+    float u1 = u0 + (float)OVERLAY_CELL_W / OVERLAY_ATLAS_W;
+    float v1 = v0 + (float)OVERLAY_CELL_H / OVERLAY_ATLAS_H;
+    if (glyph == OVERLAY_SOLID_GLYPH) {
+        // Środek komórki - przy filtrowaniu NEAREST bez ryzyka trafienia w sąsiedni znak
+        u0 = u1 = (u0 + u1) * 0.5f;
+        v0 = v1 = (v0 + v1) * 0.5f;
+    }
+    const float corners[6][4] = {
+        { x, y, u0, v0 }, { x + w, y, u1, v0 }, { x + w, y + h, u1, v1 },
+        { x, y, u0, v0 }, { x + w, y + h, u1, v1 }, { x, y + h, u0, v1 },
+    };
+    for (int i = 0; i < 6; i++) {
+        OverlayVertex* vertex = &overlay->vertices[overlay->numVertices++];
+        vertex->x = corners[i][0];
+        vertex->y = corners[i][1];
+        vertex->u = corners[i][2];
+        vertex->v = corners[i][3];
+        vertex->r = (unsigned char)(color >> 24);
+        vertex->g = (unsigned char)(color >> 16);
+        vertex->b = (unsigned char)(color >> 8);
+        vertex->a = (unsigned char)color;
+    }
+}
+
+static inline void overlayRect(Overlay* overlay, float x, float y, float w, float h, unsigned int color) {
+    overlayQuad(overlay, x, y, w, h, OVERLAY_SOLID_GLYPH, color);
+}
+
+// Tekst od (x, y), scale = powiększenie komórki 6x8
+static inline void overlayText(Overlay* overlay, float x, float y, float scale, const char* text, unsigned int color) {
+    for (; *text; text++, x += OVERLAY_CELL_W * scale) {
+        int c = toupper((unsigned char)*text);
+        if (c <= ' ' || c > '_')
+            continue;
+        overlayQuad(overlay, x, y, OVERLAY_CELL_W * scale, OVERLAY_CELL_H * scale, c - ' ', color);
+    }
+}
+
+// Wykres ostatnich OVERLAY_GRAPH_FRAMES czasów klatki, najnowsza z prawej; linie 16,7 i 33,3 ms
+static inline void overlayGraph(Overlay* overlay, float x, float y, float w, float h, float maxMs) {
+    overlayRect(overlay, x, y, w, h, 0x00000080u);
+    float barW = w / OVERLAY_GRAPH_FRAMES;
+    for (int i = 0; i < OVERLAY_GRAPH_FRAMES; i++) {
+        float ms = overlay->frameMs[(overlay->graphPos + i) % OVERLAY_GRAPH_FRAMES];
+        float barH = ms >= maxMs ? h : h * ms / maxMs;
+        unsigned int color = ms > 33.4f ? 0xFF4040FFu : (ms > 16.7f ? 0xFFC040FFu : 0x40FF40FFu);
+        if (barH > 0.0f)
+            overlayRect(overlay, x + i * barW, y + h - barH, barW, barH, color);
+    }
+    if (maxMs > 16.7f) overlayRect(overlay, x, y + h - h * 16.7f / maxMs, w, 1.0f, 0xFFFFFF80u);
+    if (maxMs > 33.3f) overlayRect(overlay, x, y + h - h * 33.3f / maxMs, w, 1.0f, 0xFFFFFF80u);
+}
+
+// Wysłanie zebranych prostokątów jednym wywołaniem rysowania, bez testu głębi
+static inline void overlayDraw(Overlay* overlay, int width, int height) {
+    if (!overlay->program || overlay->numVertices == 0)
+        return;
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(overlay->program);
+    glUniform2f(overlay->screenSizeLoc, (float)width, (float)height);
+    glUniform1i(overlay->fontTextureLoc, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, overlay->texture);
+
+    // Nowy magazyn bufora w każdej klatce - sterownik nie czeka, aż GPU skończy czytać poprzedni
+    glBindBuffer(GL_ARRAY_BUFFER, overlay->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(OverlayVertex) * overlay->numVertices, overlay->vertices, GL_STREAM_DRAW);
+    if (overlay->vao) {
+        glBindVertexArray(overlay->vao);
+    } else {
+        glEnableVertexAttribArray(overlay->posLoc);
+        glVertexAttribPointer(overlay->posLoc, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)0);
+        glEnableVertexAttribArray(overlay->texCoordLoc);
+        glVertexAttribPointer(overlay->texCoordLoc, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (void*)(sizeof(float) * 2));
+        glEnableVertexAttribArray(overlay->colorLoc);
+        glVertexAttribPointer(overlay->colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(OverlayVertex), (void*)(sizeof(float) * 4));
+    }
+    glDrawArrays(GL_TRIANGLES, 0, overlay->numVertices);
+    if (!overlay->vao) {
+        // Bez VAO włączone tablice zostałyby dla następnego programu
+        glDisableVertexAttribArray(overlay->posLoc);
+        glDisableVertexAttribArray(overlay->texCoordLoc);
+        glDisableVertexAttribArray(overlay->colorLoc);
+    }
+    glEnable(GL_DEPTH_TEST);
+}
+
+#endif
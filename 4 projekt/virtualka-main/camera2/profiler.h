@@ -0,0 +1,137 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Lekkie strefy pomiaru czasu CPU (profilerBegin / profilerEnd) z zapisem w formacie Chrome trace
+// (chrome://tracing, Perfetto). Każdy wątek ma własny bufor cykliczny, do którego pisze tylko on,
+// więc pomiar nie wymaga blokad; przy przepełnieniu nadpisywane są najstarsze strefy.
+// Czas z std::chrono::steady_clock - przenośny, w przeciwieństwie do RDTSC niezależny od zmian
+// taktowania rdzenia.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+// Wątek główny, pełna pula (THREAD_POOL_MAX_WORKERS = 16) i zapas na wątki pomocnicze
+// (budowa shaderów, druga pula pomiaru); wątki ponad limit pomijane są z ostrzeżeniem
+#define PROFILER_MAX_THREADS 32
+#define PROFILER_RING_SIZE 65536    // stref na wątek, potęga dwójki
+#define PROFILER_MAX_DEPTH 32       // zagnieżdżenie stref
+
+typedef struct {
+    const char* name;               // literał - zapisywany bez kopiowania
+    int64_t start;                  // ns od profilerInit
+    int64_t duration;               // ns
+} ProfileEvent;
+
+typedef struct {
+    ProfileEvent events[PROFILER_RING_SIZE];
+    std::atomic<uint32_t> written;  // liczba zamkniętych stref (licznik się zawija)
+    const char* openNames[PROFILER_MAX_DEPTH];
+    int64_t openStarts[PROFILER_MAX_DEPTH];
+    int depth;
+    int id;
+} ProfileThread;
+
+static std::chrono::steady_clock::time_point profilerStart = std::chrono::steady_clock::now();
+static std::atomic<ProfileThread*> profilerThreads[PROFILER_MAX_THREADS];
+static std::atomic<int> profilerThreadCount(0);
+static std::atomic<int> profilerRefused(0);
+static thread_local ProfileThread* profilerLocal = NULL;
+
+static inline void profilerInit(void) {
+    profilerStart = std::chrono::steady_clock::now();
+}
+
+static inline int64_t profilerNow(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerStart).count();
+}
+
+// Bufor bieżącego wątku, tworzony przy pierwszej strefie; NULL gdy brak miejsca lub pamięci
+static inline ProfileThread* profilerThread(void) {
+    if (profilerLocal)
+        return profilerLocal;
+    int id = PROFILER_MAX_THREADS;
+    if (profilerThreadCount.load(std::memory_order_relaxed) < PROFILER_MAX_THREADS)
+        id = profilerThreadCount.fetch_add(1);
+    if (id >= PROFILER_MAX_THREADS) {
+        if (profilerRefused.exchange(1) == 0)
+            fprintf(stderr, "Profiler: więcej niż %d wątków - strefy kolejnych wątków nie trafią do trace\n",
+                    PROFILER_MAX_THREADS);
+        return NULL;
+    }
+    ProfileThread* thread = (ProfileThread*)calloc(1, sizeof(ProfileThread));
+    if (!thread)
+        return NULL;
+    thread->id = id;
+    profilerThreads[id].store(thread, std::memory_order_release);
+    profilerLocal = thread;
+    return thread;
+}
+
+static inline void profilerBegin(const char* name) {
+    ProfileThread* thread = profilerThread();
+    if (!thread)
+        return;
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        thread->openNames[thread->depth] = name;
+        thread->openStarts[thread->depth] = profilerNow();
+    }
+    thread->depth++;
+}
+
+// Zamyka ostatnio otwartą strefę wątku
+static inline void profilerEnd(void) {
+    ProfileThread* thread = profilerLocal;
+    if (!thread || thread->depth == 0)
+        return;
+    thread->depth--;
+    if (thread->depth >= PROFILER_MAX_DEPTH)
+        return;
+    uint32_t index = thread->written.load(std::memory_order_relaxed);
+    ProfileEvent* event = &thread->events[index & (PROFILER_RING_SIZE - 1)];
+    event->name = thread->openNames[thread->depth];
+    event->start = thread->openStarts[thread->depth];
+    event->duration = profilerNow() - event->start;
+    thread->written.store(index + 1, std::memory_order_release);
+}
+
+// Zapis zawartości buforów wszystkich wątków jako Chrome trace JSON; zwraca 0 przy błędzie
+static inline int profilerWriteTrace(const char* fileName) {
+    FILE* file = fopen(fileName, "w");
+    if (!file) {
+        fprintf(stderr, "Nie można zapisać %s\n", fileName);
+        return 0;
+    }
+    int threads = profilerThreadCount.load();
+    if (threads > PROFILER_MAX_THREADS)
+        threads = PROFILER_MAX_THREADS;
+    long total = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int t = 0; t < threads; t++) {
+        ProfileThread* thread = profilerThreads[t].load(std::memory_order_acquire);
+        if (!thread)
+            continue;
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+                total || t ? ",\n" : "", t, t == 0 ? "glowny" : "watek", t);
+        uint32_t written = thread->written.load(std::memory_order_acquire);
+        uint32_t first = written > PROFILER_RING_SIZE ? written - PROFILER_RING_SIZE : 0;
+        for (uint32_t i = first; i != written; i++) {
+            const ProfileEvent* event = &thread->events[i & (PROFILER_RING_SIZE - 1)];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    event->name, event->start / 1000.0, event->duration / 1000.0, t);
+            total++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    int ok = !ferror(file);
+    fclose(file);
+    if (ok)
+        printf("Zapisano %ld stref CPU do %s\n", total, fileName);
+    else
+        fprintf(stderr, "Błąd zapisu %s\n", fileName);
+    return ok;
+}
+
+#endif
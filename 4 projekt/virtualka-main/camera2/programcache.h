@@ -0,0 +1,181 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+// Pamięć podręczna zlinkowanych programów na dysku (glGetProgramBinary / glProgramBinary).
+// Klucz to skrót FNV-1a tekstów źródeł przekazywanych do glShaderSource oraz napisów
+// GL_VENDOR / GL_RENDERER / GL_VERSION, więc zmiana shadera, sterownika albo profilu kontekstu
+// daje nowy plik. Gdy sterownik odrzuci zapisany program (np. po aktualizacji o tej samej wersji),
+// program jest kompilowany ze źródeł i zapisywany ponownie.
+// Wymaga wcześniejszego dołączenia glad.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define PROGRAM_CACHE_MAGIC 0x4E494250u   // "PBIN"
+#define PROGRAM_CACHE_VERSION 1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;        // binaryFormat z glGetProgramBinary
+    uint32_t length;
+} ProgramCacheHeader;
+
+typedef struct {
+    int enabled;            // 0 gdy wyłączona albo sterownik nie ma żadnego formatu binarnego
+    const char* dir;
+    uint64_t driverHash;    // skrót napisów sterownika - początek każdego klucza
+    int hits, misses;
+} ProgramCache;
+
+static inline uint64_t programCacheHashBytes(uint64_t hash, const char* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    // Separator - "ab" + "c" i "a" + "bc" dają różne skróty
+    hash ^= 0xFF;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+static inline uint64_t programCacheHash(uint64_t hash, const char* text) {
+    return programCacheHashBytes(hash, text, strlen(text));
+}
+
+// Po załadowaniu funkcji GL
+static inline void programCacheInit(ProgramCache* cache, const char* dir, int enabled) {
+    memset(cache, 0, sizeof(*cache));
+    cache->dir = dir;
+    if (!enabled)
+        return;
+    if (!GLAD_GL_ARB_get_program_binary) {
+        fprintf(stderr, "Brak GL_ARB_get_program_binary - shadery będą kompilowane przy każdym starcie\n");
+        return;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats < 1) {
+        fprintf(stderr, "Sterownik nie obsługuje zapisu programów - shadery będą kompilowane przy każdym starcie\n");
+        return;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    hash = programCacheHash(hash, (const char*)glGetString(GL_VENDOR));
+    hash = programCacheHash(hash, (const char*)glGetString(GL_RENDERER));
+    hash = programCacheHash(hash, (const char*)glGetString(GL_VERSION));
+    cache->driverHash = hash;
+    cache->enabled = 1;
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+}
+
+// Klucz programu z części źródeł obu shaderów (tak jak idą do glShaderSource - z jawnymi długościami)
+static inline uint64_t programCacheKey(const ProgramCache* cache,
+                                       const char* const* vertParts, const GLint* vertLengths, int numVert,
+                                       const char* const* fragParts, const GLint* fragLengths, int numFrag) {
+    uint64_t hash = cache->driverHash;
+    for (int i = 0; i < numVert; i++)
+        hash = programCacheHashBytes(hash, vertParts[i], (size_t)vertLengths[i]);
+    hash = programCacheHash(hash, "");
+    for (int i = 0; i < numFrag; i++)
+        hash = programCacheHashBytes(hash, fragParts[i], (size_t)fragLengths[i]);
+    return hash;
+}
+
+static inline void programCachePath(const ProgramCache* cache, uint64_t key, char* path, size_t size) {
+    snprintf(path, size, "%s/%016llx.bin", cache->dir, (unsigned long long)key);
+}
+
+// Program z pliku albo 0, gdy go nie ma lub sterownik go odrzucił
+static inline GLuint programCacheLoad(ProgramCache* cache, uint64_t key) {
+    if (!cache->enabled)
+        return 0;
+    char path[256];
+    programCachePath(cache, key, path, sizeof(path));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        cache->misses++;
+        return 0;
+    }
+    ProgramCacheHeader header;
+    void* binary = NULL;
+    int ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == PROGRAM_CACHE_MAGIC &&
+             header.version == PROGRAM_CACHE_VERSION && header.key == key && header.length > 0;
+    if (ok) {
+        binary = malloc(header.length);
+        ok = binary && fread(binary, 1, header.length, file) == header.length;
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (ok) {
+        program = glCreateProgram();
+        glProgramBinary(program, (GLenum)header.format, binary, (GLsizei)header.length);
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    free(binary);
+    if (program)
+        cache->hits++;
+    else
+        cache->misses++;
+    return program;
+}
+
+// Przed glLinkProgram - bez tej wskazówki część sterowników nie zwraca binarnej postaci
+static inline void programCachePrepare(const ProgramCache* cache, GLuint program) {
+    if (cache->enabled)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+// Zapis zlinkowanego programu; błędy tylko wypisywane - program działa i bez pliku
+static inline void programCacheStore(const ProgramCache* cache, uint64_t key, GLuint program) {
+    if (!cache->enabled)
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    void* binary = malloc(length);
+    if (!binary)
+        return;
+    ProgramCacheHeader header;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary);
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = (uint32_t)length;
+
+    char path[256];
+    programCachePath(cache, key, path, sizeof(path));
+    FILE* file = fopen(path, "wb");
+    int ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(binary, 1, length, file) == (size_t)length;
+    if (file)
+        fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Nie można zapisać programu do %s\n", path);
+        remove(path);
+    }
+    free(binary);
+}
+
+#endif
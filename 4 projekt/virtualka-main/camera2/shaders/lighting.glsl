@@ -0,0 +1,35 @@
+// Oświetlenie jednym światłem punktowym - wspólne dla shaderów fragmentów z LIGHTING
+#ifndef LIGHTING_GLSL
+#define LIGHTING_GLSL
+
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform vec3 viewPos;
+
+varying vec3 fragPos;
+varying vec3 normal;
+
+// Światło rozproszone (diffuse)
+vec3 lightDiffuse(vec3 N, vec3 lightDir)
+{
+    float diff = max(dot(N, lightDir), 0.0);
+    return diff * lightColor;
+}
+
+#ifndef LIGHT_DIFFUSE
+// Światło odbite (specular): Phong - wektor odbity, Blinn-Phong - wektor połówkowy
+vec3 lightSpecular(vec3 N, vec3 lightDir)
+{
+    vec3 viewDir = normalize(viewPos - fragPos);
+#ifdef LIGHT_PHONG
+    vec3 reflectDir = reflect(-lightDir, N);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+#else
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(N, halfwayDir), 0.0), 32.0);
+#endif
+    return spec * lightColor;
+}
+#endif
+
+#endif
@@ -0,0 +1,75 @@
+// Wspólny shader fragmentów. Wariant wybierają definicje przed #include (albo wstrzyknięte z programu):
+// LIGHT_DIFFUSE / LIGHT_PHONG / LIGHT_BLINN_PHONG - model oświetlenia (bez żadnego: bez oświetlenia)
+// SPECULAR_UNTINTED - odblask w kolorze światła, nie mnożony przez kolor obiektu
+// TEXTURED - kolor z tekstury zamiast koloru obiektu
+// TEXTURE_ARRAY - tekstura to warstwa textureLayer tablicy tekstur (wstrzykiwane z programu, gdy sterownik je obsługuje)
+// DEBUG_NORMALS - normalne zamiast oświetlenia (podgląd, np. --shader-define DEBUG_NORMALS)
+
+#ifdef TEXTURE_ARRAY
+#if __VERSION__ < 130
+#extension GL_EXT_texture_array : require
+#endif
+#endif
+
+#ifdef LIGHT_DIFFUSE
+#define LIGHTING
+#endif
+#ifdef LIGHT_PHONG
+#define LIGHTING
+#endif
+#ifdef LIGHT_BLINN_PHONG
+#define LIGHTING
+#endif
+
+#ifdef LIGHTING
+#include "lighting.glsl"
+#endif
+
+#ifdef TEXTURED
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray textureSampler;
+uniform float textureLayer;
+#else
+uniform sampler2D textureSampler;
+#endif
+
+varying vec2 texCoord;
+#else
+varying vec3 color;
+#endif
+
+void main()
+{
+#ifdef TEXTURED
+#ifdef TEXTURE_ARRAY
+    vec4 base = texture2DArray(textureSampler, vec3(texCoord, textureLayer));
+#else
+    vec4 base = texture2D(textureSampler, texCoord);
+#endif
+#else
+    vec4 base = vec4(color, 1.0);
+#endif
+#ifdef LIGHTING
+    // Normalizacja
+    vec3 N = normalize(normal);
+    vec3 lightDir = normalize(lightPos - fragPos);
+    vec3 ambient = vec3(0.1, 0.1, 0.1);
+    vec3 diffuse = lightDiffuse(N, lightDir);
+#ifdef LIGHT_DIFFUSE
+    vec3 result = (diffuse + ambient) * base.rgb;
+#else
+    vec3 specular = lightSpecular(N, lightDir);
+#ifdef SPECULAR_UNTINTED
+    vec3 result = ambient * base.rgb + diffuse * base.rgb + specular;
+#else
+    vec3 result = (ambient + diffuse + specular) * base.rgb;
+#endif
+#endif
+#ifdef DEBUG_NORMALS
+    result = N * 0.5 + 0.5;
+#endif
+    gl_FragColor = vec4(result, base.a);
+#else
+    gl_FragColor = base;
+#endif
+}
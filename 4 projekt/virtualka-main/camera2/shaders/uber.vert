@@ -0,0 +1,51 @@
+// Wspólny shader wierzchołków. Wariant wybierają definicje przed #include (albo wstrzyknięte z programu):
+// LIGHTING - pozycja i normalna w przestrzeni świata dla oświetlenia
+// TEXTURED - współrzędne tekstury zamiast koloru obiektu
+// ANIMATED - falowanie flagi w czasie
+
+uniform mat4 MVP;
+#ifdef LIGHTING
+uniform mat4 M;
+#endif
+#ifdef ANIMATED
+uniform float time;
+#endif
+#ifndef TEXTURED
+uniform vec3 objectColor;  // Kolor obiektu
+#endif
+
+attribute vec3 vPos;
+#ifdef LIGHTING
+attribute vec3 vNormal;
+
+varying vec3 fragPos;
+varying vec3 normal;
+#endif
+#ifdef TEXTURED
+attribute vec2 vTexCoord;
+
+varying vec2 texCoord;
+#else
+varying vec3 color;
+#endif
+
+void main()
+{
+    vec3 pos = vPos;
+#ifdef ANIMATED
+    // Efekt falowania flagi
+    float wave = sin(pos.x * 3.0 + time * 2.0) * 0.1;
+    pos.y += wave;
+#endif
+#ifdef LIGHTING
+    fragPos = vec3(M * vec4(pos, 1.0));
+    // Transformacja normalnej przez macierz 4x4 (GLSL 110 nie wspiera mat3(M))
+    normal = normalize(vec3(M * vec4(vNormal, 0.0)));
+#endif
+#ifdef TEXTURED
+    texCoord = vTexCoord;
+#else
+    color = objectColor;
+#endif
+    gl_Position = MVP * vec4(pos, 1.0);
+}
@@ -0,0 +1,362 @@
+#ifndef SHADERSOURCE_H
+#define SHADERSOURCE_H
+
+// Składanie źródła shadera z plików przed glShaderSource:
+// - #include "plik" - ścieżka względem pliku z dyrektywą; źródła dołączanych plików numerowane są
+//   w kolejności pierwszego użycia (0 = plik główny), a #line sprawia, że błędy kompilatora
+//   wskazują "numer_pliku:linia"
+// - definicje wstrzykiwane z programu (np. "DEBUG_NORMALS" albo "SHININESS 64.0") trafiają zaraz
+//   po #version
+// - bloki #ifdef / #ifndef / #else / #endif są rozstrzygane tutaj na podstawie #define z plików
+//   i definicji wstrzykniętych, więc każdy wariant (permutacja) dostaje do kompilacji tylko swój kod,
+//   a jego skrót - klucz pamięci podręcznej programów - nie zależy od martwych gałęzi. #if / #elif
+//   z wyrażeniami przechodzą bez zmian do kompilatora GLSL; #define / #undef wewnątrz nich są błędem,
+//   bo nie wiadomo, która gałąź obowiązuje.
+// Wynik to lista fragmentów zmapowanych plików (bez kopiowania) i kilku wygenerowanych linii;
+// pominięte linie zastępowane są pustymi, więc numery linii się nie zmieniają.
+// Wymaga wcześniejszego dołączenia glad.h i assetfile.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define SHADER_SOURCE_MAX_PARTS 512
+#define SHADER_SOURCE_MAX_FILES 16
+#define SHADER_SOURCE_MAX_DEFINES 64
+#define SHADER_SOURCE_MAX_NAME 64
+#define SHADER_SOURCE_MAX_DEPTH 8       // zagnieżdżenie #include
+#define SHADER_SOURCE_MAX_CONDITIONS 32 // zagnieżdżenie #if*
+#define SHADER_SOURCE_TEXT 2048         // wygenerowane linie (#version, #define, #line)
+
+typedef struct {
+    int ours;               // 1 = #ifdef/#ifndef rozstrzygany tutaj, 0 = przekazywany kompilatorowi
+    int active;             // czy linie w bieżącej gałęzi trafiają do wyniku
+    int parentActive;
+} ShaderCondition;
+
+typedef struct {
+    const char* parts[SHADER_SOURCE_MAX_PARTS];
+    GLint lengths[SHADER_SOURCE_MAX_PARTS];
+    int numParts;
+    char files[SHADER_SOURCE_MAX_FILES][ASSET_PATH_MAX];   // plik główny i dołączone (do obserwacji zmian)
+    int numFiles;
+    char defines[SHADER_SOURCE_MAX_DEFINES][SHADER_SOURCE_MAX_NAME];
+    int numDefines;
+    ShaderCondition conditions[SHADER_SOURCE_MAX_CONDITIONS];
+    int numConditions;
+    int lineOffset;         // #line N w GLSL < 330 ustawia numer następnej linii na N + 1
+    int blankLines;         // pominięte linie czekające na zastąpienie pustymi
+    char text[SHADER_SOURCE_TEXT];
+    int textUsed;
+    int failed;
+} ShaderSource;
+
+static const char shaderSourceNewlines[] = "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n";
+
+static inline void shaderSourceEmit(ShaderSource* src, const char* data, int length) {
+    if (length <= 0)
+        return;
+    // Ciągły fragment tego samego pliku - wydłużamy poprzednią część
+    if (src->numParts > 0 && src->parts[src->numParts - 1] + src->lengths[src->numParts - 1] == data) {
+        src->lengths[src->numParts - 1] += length;
+        return;
+    }
+    if (src->numParts == SHADER_SOURCE_MAX_PARTS) {
+        fprintf(stderr, "Za dużo fragmentów źródła shadera\n");
+        src->failed = 1;
+        return;
+    }
+    src->parts[src->numParts] = data;
+    src->lengths[src->numParts] = length;
+    src->numParts++;
+}
+
+static inline void shaderSourceFlushBlank(ShaderSource* src) {
+    const int chunk = (int)sizeof(shaderSourceNewlines) - 1;
+    for (int count = src->blankLines; count > 0; count -= chunk)
+        shaderSourceEmit(src, shaderSourceNewlines, count < chunk ? count : chunk);
+    src->blankLines = 0;
+}
+
+static inline void shaderSourceEmitText(ShaderSource* src, const char* format, ...) {
+    shaderSourceFlushBlank(src);
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(src->text + src->textUsed, SHADER_SOURCE_TEXT - src->textUsed, format, args);
+    va_end(args);
+    if (length < 0 || src->textUsed + length >= SHADER_SOURCE_TEXT) {
+        fprintf(stderr, "Za dużo wygenerowanych linii źródła shadera\n");
+        src->failed = 1;
+        return;
+    }
+    // Znak NUL zostaje między tekstami, więc kolejny nie zostanie doklejony do tej samej części
+    const char* data = src->text + src->textUsed;
+    src->textUsed += length + 1;
+    shaderSourceEmit(src, data, length);
+}
+
+static inline int shaderSourceDefined(const ShaderSource* src, const char* name, int length) {
+    for (int i = 0; i < src->numDefines; i++) {
+        if ((int)strlen(src->defines[i]) == length && strncmp(src->defines[i], name, length) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static inline void shaderSourceDefine(ShaderSource* src, const char* name, int length) {
+    if (length <= 0 || length >= SHADER_SOURCE_MAX_NAME || shaderSourceDefined(src, name, length) >= 0)
+        return;
+    if (src->numDefines == SHADER_SOURCE_MAX_DEFINES) {
+        fprintf(stderr, "Za dużo definicji w shaderze\n");
+        src->failed = 1;
+        return;
+    }
+    memcpy(src->defines[src->numDefines], name, length);
+    src->defines[src->numDefines][length] = '\0';
+    src->numDefines++;
+}
+
+static inline void shaderSourceUndefine(ShaderSource* src, const char* name, int length) {
+    int index = shaderSourceDefined(src, name, length);
+    if (index >= 0) {
+        src->numDefines--;
+        memcpy(src->defines[index], src->defines[src->numDefines], SHADER_SOURCE_MAX_NAME);
+    }
+}
+
+static inline int shaderSourceIsSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static inline int shaderSourceIsIdent(char c) {
+    return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+// Długość identyfikatora zaczynającego się w p (przed end)
+static inline int shaderSourceIdent(const char* p, const char* end) {
+    int length = 0;
+    while (p + length < end && shaderSourceIsIdent(p[length]))
+        length++;
+    return length;
+}
+
+// Indeks pliku na liście (dopisuje nowy)
+static inline int shaderSourceFileIndex(ShaderSource* src, const char* path) {
+    for (int i = 0; i < src->numFiles; i++) {
+        if (strcmp(src->files[i], path) == 0)
+            return i;
+    }
+    if (src->numFiles == SHADER_SOURCE_MAX_FILES) {
+        fprintf(stderr, "Za dużo plików dołączonych do shadera\n");
+        src->failed = 1;
+        return 0;
+    }
+    snprintf(src->files[src->numFiles], ASSET_PATH_MAX, "%s", path);
+    return src->numFiles++;
+}
+
+static inline int shaderSourceActive(const ShaderSource* src) {
+    return src->numConditions == 0 || src->conditions[src->numConditions - 1].active;
+}
+
+// Czy bieżąca linia leży w bloku #if / #elif przekazywanym kompilatorowi (którejś z jego gałęzi)
+static inline int shaderSourceInPassThrough(const ShaderSource* src) {
+    for (int i = 0; i < src->numConditions; i++)
+        if (!src->conditions[i].ours)
+            return 1;
+    return 0;
+}
+
+static inline void shaderSourceAddFile(ShaderSource* src, AssetPool* pool, const char* path, int depth,
+                                       const char* versionHeader, const char* const* defines);
+
+// Obsługa jednej dyrektywy; zwraca 1 gdy linia ma trafić do wyniku bez zmian, 0 gdy ma być pominięta
+// i -1 gdy została już zastąpiona (#include)
+static inline int shaderSourceDirective(ShaderSource* src, AssetPool* pool, const char* path, int fileIndex,
+                                        int lineNumber, int depth, const char* p, const char* end) {
+    int length = shaderSourceIdent(p, end);
+    const char* arg = p + length;
+    while (arg < end && shaderSourceIsSpace(*arg))
+        arg++;
+    int argLength = shaderSourceIdent(arg, end);
+    int active = shaderSourceActive(src);
+
+    if ((length == 5 && strncmp(p, "ifdef", 5) == 0) || (length == 6 && strncmp(p, "ifndef", 6) == 0)) {
+        if (src->numConditions == SHADER_SOURCE_MAX_CONDITIONS) {
+            fprintf(stderr, "%s:%d: za głębokie zagnieżdżenie #ifdef\n", path, lineNumber);
+            src->failed = 1;
+            return 0;
+        }
+        int defined = shaderSourceDefined(src, arg, argLength) >= 0;
+        ShaderCondition* condition = &src->conditions[src->numConditions++];
+        condition->ours = 1;
+        condition->parentActive = active;
+        condition->active = active && (length == 5 ? defined : !defined);
+        return 0;
+    }
+    if (length == 2 && strncmp(p, "if", 2) == 0) {
+        if (src->numConditions == SHADER_SOURCE_MAX_CONDITIONS) {
+            fprintf(stderr, "%s:%d: za głębokie zagnieżdżenie #if\n", path, lineNumber);
+            src->failed = 1;
+            return 0;
+        }
+        ShaderCondition* condition = &src->conditions[src->numConditions++];
+        condition->ours = 0;
+        condition->parentActive = condition->active = active;
+        return active;
+    }
+    if ((length == 4 && strncmp(p, "else", 4) == 0) || (length == 4 && strncmp(p, "elif", 4) == 0) ||
+        (length == 5 && strncmp(p, "endif", 5) == 0)) {
+        if (src->numConditions == 0) {
+            fprintf(stderr, "%s:%d: #%.*s bez #if\n", path, lineNumber, length, p);
+            src->failed = 1;
+            return 0;
+        }
+        ShaderCondition* condition = &src->conditions[src->numConditions - 1];
+        if (p[1] == 'n')
+            src->numConditions--;
+        if (!condition->ours)
+            return condition->parentActive;
+        if (p[2] == 'i') {
+            fprintf(stderr, "%s:%d: #elif po #ifdef nie jest obsługiwany\n", path, lineNumber);
+            src->failed = 1;
+        } else if (p[1] == 'l') {
+            condition->active = condition->parentActive && !condition->active;
+        }
+        return 0;
+    }
+    if (!active)
+        return 0;
+
+    if ((length == 6 && strncmp(p, "define", 6) == 0) || (length == 5 && strncmp(p, "undef", 5) == 0)) {
+        // Gałęzi #if / #elif nie rozstrzygamy, więc nie wiadomo, czy definicja obowiązuje -
+        // późniejszy #ifdef byłby rozstrzygnięty błędnie
+        if (shaderSourceInPassThrough(src)) {
+            fprintf(stderr, "%s:%d: #%.*s wewnątrz #if / #elif nie jest obsługiwany (użyj #ifdef)\n",
+                    path, lineNumber, length, p);
+            src->failed = 1;
+            return 0;
+        }
+        if (length == 6)
+            shaderSourceDefine(src, arg, argLength);
+        else
+            shaderSourceUndefine(src, arg, argLength);
+        return 1;
+    }
+    if (length == 7 && strncmp(p, "version", 7) == 0) {
+        if (depth > 0 || lineNumber > 1) {
+            fprintf(stderr, "%s:%d: #version dozwolone tylko w pierwszej linii pliku głównego\n", path, lineNumber);
+            src->failed = 1;
+        }
+        return 0;   // pierwsza linia pliku głównego obsługiwana jest w shaderSourceAddFile
+    }
+    if (length == 7 && strncmp(p, "include", 7) == 0) {
+        const char* open = (const char*)memchr(arg, '"', end - arg);
+        const char* close = open ? (const char*)memchr(open + 1, '"', end - open - 1) : NULL;
+        if (!close) {
+            fprintf(stderr, "%s:%d: oczekiwano #include \"plik\"\n", path, lineNumber);
+            src->failed = 1;
+            return 0;
+        }
+        if (depth + 1 >= SHADER_SOURCE_MAX_DEPTH) {
+            fprintf(stderr, "%s:%d: za głębokie zagnieżdżenie #include (cykl?)\n", path, lineNumber);
+            src->failed = 1;
+            return 0;
+        }
+        // Ścieżka względem katalogu bieżącego pliku
+        char includePath[ASSET_PATH_MAX];
+        const char* slash = strrchr(path, '/');
+        int dirLength = slash ? (int)(slash - path + 1) : 0;
+        snprintf(includePath, sizeof(includePath), "%.*s%.*s", dirLength, path, (int)(close - open - 1), open + 1);
+        int includeIndex = shaderSourceFileIndex(src, includePath);
+        shaderSourceEmitText(src, "#line %d %d\n", 1 + src->lineOffset, includeIndex);
+        shaderSourceAddFile(src, pool, src->files[includeIndex], depth + 1, NULL, NULL);
+        shaderSourceEmitText(src, "#line %d %d\n", lineNumber + 1 + src->lineOffset, fileIndex);
+        return -1;
+    }
+    return 1;   // #extension, #pragma, #line i inne dla kompilatora
+}
+
+static inline void shaderSourceAddFile(ShaderSource* src, AssetPool* pool, const char* path, int depth,
+                                       const char* versionHeader, const char* const* defines) {
+    AssetView view;
+    if (!assetPoolGet(pool, path, &view)) {
+        src->failed = 1;
+        return;
+    }
+    int fileIndex = shaderSourceFileIndex(src, path);
+    int conditionsAtStart = src->numConditions;
+    const char* end = view.data + view.length;
+    int lineNumber = 0;
+    for (const char* line = view.data; line < end && !src->failed; ) {
+        const char* next = (const char*)memchr(line, '\n', end - line);
+        next = next ? next + 1 : end;
+        lineNumber++;
+
+        const char* p = line;
+        while (p < next && shaderSourceIsSpace(*p))
+            p++;
+        int directive = p < next && *p == '#';
+        if (directive) {
+            p++;
+            while (p < next && shaderSourceIsSpace(*p))
+                p++;
+        }
+        if (depth == 0 && lineNumber == 1) {
+            // #version pliku głównego, ewentualnie podmieniony (np. GLSL 330 w core profile),
+            // a po nim definicje wstrzyknięte z programu
+            int hasVersion = directive && next - p >= 7 && strncmp(p, "version", 7) == 0;
+            if (versionHeader)
+                src->lineOffset = atoi(versionHeader + 9) >= 330 ? 0 : -1;
+            else if (hasVersion)
+                src->lineOffset = atoi(p + 7) >= 330 ? 0 : -1;
+            if (versionHeader)
+                shaderSourceEmitText(src, "%s", versionHeader);
+            else if (hasVersion)
+                shaderSourceEmit(src, line, (int)(next - line));
+            for (int i = 0; defines && defines[i]; i++) {
+                shaderSourceDefine(src, defines[i], shaderSourceIdent(defines[i], defines[i] + strlen(defines[i])));
+                shaderSourceEmitText(src, "#define %s\n", defines[i]);
+            }
+            if (versionHeader || (defines && defines[0]))
+                shaderSourceEmitText(src, "#line %d 0\n", (hasVersion ? 2 : 1) + src->lineOffset);
+            if (hasVersion) {
+                line = next;
+                continue;
+            }
+        }
+        int keep = directive ? shaderSourceDirective(src, pool, path, fileIndex, lineNumber, depth, p, next)
+                             : shaderSourceActive(src);
+
+        if (keep > 0) {
+            shaderSourceFlushBlank(src);
+            shaderSourceEmit(src, line, (int)(next - line));
+        } else if (keep == 0 && next[-1] == '\n') {
+            src->blankLines++;
+        }
+        line = next;
+    }
+    shaderSourceFlushBlank(src);
+    // Plik bez końcowego znaku nowej linii - kolejny fragment zaczynałby się w tej samej linii
+    if (view.length > 0 && view.data[view.length - 1] != '\n')
+        shaderSourceEmit(src, shaderSourceNewlines, 1);
+    if (src->numConditions != conditionsAtStart && !src->failed) {
+        fprintf(stderr, "%s: brak #endif\n", path);
+        src->failed = 1;
+    }
+}
+
+// Źródło shadera z pliku głównego path. versionHeader (może być NULL) zastępuje linię #version,
+// defines - lista zakończona NULL (może być NULL). Zwraca 0 przy błędzie (opis na stderr).
+// Fragmenty wskazują na zmapowane pliki z puli i są ważne do ich ponownego pobrania z puli
+// albo do assetPoolRelease (najlepiej zaraz po glShaderSource).
+static inline int shaderSourceBuild(ShaderSource* src, AssetPool* pool, const char* path,
+                                    const char* versionHeader, const char* const* defines) {
+    memset(src, 0, sizeof(*src));
+    src->lineOffset = -1;
+    shaderSourceAddFile(src, pool, path, 0, versionHeader, defines);
+    return !src->failed;
+}
+
+#endif
@@ -0,0 +1,365 @@
+#ifndef TEXCOMPRESS_H
+#define TEXCOMPRESS_H
+
+// Kompresja tekstur RGB do BC1 (S3TC DXT1): blok 4x4 piksele to dwa kolory 565 i 2-bitowe indeksy
+// palety czterech kolorów (dwa końce i dwa pośrednie) - 8 bajtów zamiast 48, czyli 6x mniej niż
+// GL_RGB i 8x mniej niż RGBA, w którym sterowniki zwykle i tak trzymają GL_RGB.
+// Końce palety leżą na głównej osi kolorów bloku. Bloki jednokolorowe (płaskie pola szachownic)
+// kodowane są tablicami najlepszego dopasowania koloru pośredniego, więc nie tracą odcienia na
+// zaokrągleniu do 565. Bloki całego łańcucha mipmap dzielone są między wątki puli.
+// Zakodowane łańcuchy zapisywane są w texture_cache/ pod skrótem pikseli poziomu 0, więc przy
+// następnym starcie nie trzeba ani liczyć mipmap, ani kodować.
+// Wymaga wcześniejszego dołączenia glad.h, threadpool.h, profiler.h, mipmap.h i programcache.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define BC1_BLOCK_BYTES 8
+#define TEX_COMPRESS_ROWS_PER_CHUNK 4       // rzędów bloków w jednym kawałku pracy wątku
+#define TEXTURE_CACHE_MAGIC 0x54314342u     // "BC1T"
+#define TEXTURE_CACHE_VERSION 1u            // zmiana kodera - nowa wersja, stare pliki są pomijane
+
+typedef struct {
+    int levels;
+    int width[MIP_MAX_LEVELS], height[MIP_MAX_LEVELS];
+    size_t offset[MIP_MAX_LEVELS];  // początek poziomu w blocks
+    size_t size[MIP_MAX_LEVELS];    // bajty poziomu (glCompressedTexImage*)
+    size_t totalSize;
+    unsigned char* blocks;
+} CompressedChain;
+
+typedef struct {
+    const MipChain* source;
+    CompressedChain* chain;
+    int firstRow[MIP_MAX_LEVELS + 1];   // pierwszy rząd bloków poziomu w numeracji całego łańcucha
+    ThreadPoolTask task;
+} TexCompressJob;
+
+// Najlepsze końce 5/6-bitowe (a, b), dla których kolor pośredni (2a + b) / 3 trafia w wartość 8-bitową
+static unsigned char bc1Match5[256][2];
+static unsigned char bc1Match6[256][2];
+
+static inline int bc1Expand5(int v) { return (v << 3) | (v >> 2); }
+static inline int bc1Expand6(int v) { return (v << 2) | (v >> 4); }
+
+static inline void bc1BuildMatchTable(unsigned char table[256][2], int bits) {
+    int maxValue = (1 << bits) - 1;
+    for (int value = 0; value < 256; value++) {
+        int bestError = 1 << 30;
+        for (int a = 0; a <= maxValue; a++) {
+            for (int b = 0; b <= maxValue; b++) {
+                int ea = bits == 5 ? bc1Expand5(a) : bc1Expand6(a);
+                int eb = bits == 5 ? bc1Expand5(b) : bc1Expand6(b);
+                int error = abs((2 * ea + eb) / 3 - value) * 100;
+                // Bliższe końce - mniejsza różnica między dekoderami, które zaokrąglają inaczej
+                error += abs(ea - eb) * 3;
+                if (error < bestError) {
+                    bestError = error;
+                    table[value][0] = (unsigned char)a;
+                    table[value][1] = (unsigned char)b;
+                }
+            }
+        }
+    }
+}
+
+// Raz, w wątku głównym, przed pierwszym kodowaniem
+static inline void texCompressInit(void) {
+    static int initialized = 0;
+    if (initialized)
+        return;
+    bc1BuildMatchTable(bc1Match5, 5);
+    bc1BuildMatchTable(bc1Match6, 6);
+    initialized = 1;
+}
+
+static inline int bc1Pack565(int r, int g, int b) {
+    return (((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255);
+}
+
+static inline void bc1Unpack565(int color, int* rgb) {
+    rgb[0] = bc1Expand5((color >> 11) & 31);
+    rgb[1] = bc1Expand6((color >> 5) & 63);
+    rgb[2] = bc1Expand5(color & 31);
+}
+
+static inline void bc1WriteBlock(unsigned char* out, int color0, int color1, uint32_t indices) {
+    out[0] = (unsigned char)color0;
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)color1;
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// Blok jednego koloru: wszystkie piksele wskazują kolor pośredni 2/3 color0 + 1/3 color1
+static inline void bc1EncodeSolid(const unsigned char* rgb, unsigned char* out) {
+    int color0 = (bc1Match5[rgb[0]][0] << 11) | (bc1Match6[rgb[1]][0] << 5) | bc1Match5[rgb[2]][0];
+    int color1 = (bc1Match5[rgb[0]][1] << 11) | (bc1Match6[rgb[1]][1] << 5) | bc1Match5[rgb[2]][1];
+    if (color0 == color1) {
+        bc1WriteBlock(out, color0, color1, 0);
+    } else if (color0 > color1) {
+        bc1WriteBlock(out, color0, color1, 0xAAAAAAAAu);    // indeks 2
+    } else {
+        // Tryb czterech kolorów wymaga color0 > color1 - po zamianie ten sam kolor to indeks 3
+        bc1WriteBlock(out, color1, color0, 0xFFFFFFFFu);
+    }
+}
+
+// pixels - 16 pikseli RGB bloku wierszami
+static inline void bc1EncodeBlock(const unsigned char* pixels, unsigned char* out) {
+    int solid = 1;
+    for (int i = 1; i < 16 && solid; i++)
+        solid = memcmp(pixels, pixels + i * 3, 3) == 0;
+    if (solid) {
+        bc1EncodeSolid(pixels, out);
+        return;
+    }
+
+    // Główna oś kolorów: kowariancja i kilka kroków metody potęgowej
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += pixels[i * 3 + c] / 16.0f;
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };   // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++) {
+        float r = pixels[i * 3] - mean[0], g = pixels[i * 3 + 1] - mean[1], b = pixels[i * 3 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    // Start z wiersza kanału o największej wariancji - oś (1, 1, 1) bywa prostopadła do różnicy
+    // kolorów (np. czerwony i niebieski) i metoda potęgowa by z niej nie wyszła
+    float axis[3] = { cov[0], cov[1], cov[2] };
+    if (cov[3] >= cov[0] && cov[3] >= cov[5]) {
+        axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+    } else if (cov[5] >= cov[0] && cov[5] >= cov[3]) {
+        axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+    }
+    for (int step = 0; step < 4; step++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = fabsf(x) > fabsf(y) ? fabsf(x) : fabsf(y);
+        length = length > fabsf(z) ? length : fabsf(z);
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+
+    // Końce palety - piksele skrajne na osi
+    int minIndex = 0, maxIndex = 0;
+    float minDot = 1e30f, maxDot = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        float dot = pixels[i * 3] * axis[0] + pixels[i * 3 + 1] * axis[1] + pixels[i * 3 + 2] * axis[2];
+        if (dot < minDot) { minDot = dot; minIndex = i; }
+        if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+    }
+    const unsigned char* maxColor = pixels + maxIndex * 3;
+    const unsigned char* minColor = pixels + minIndex * 3;
+    int color0 = bc1Pack565(maxColor[0], maxColor[1], maxColor[2]);
+    int color1 = bc1Pack565(minColor[0], minColor[1], minColor[2]);
+    if (color0 < color1) {
+        int swap = color0; color0 = color1; color1 = swap;
+    }
+    if (color0 == color1) {
+        bc1WriteBlock(out, color0, color1, 0);
+        return;
+    }
+
+    int palette[4][3];
+    bc1Unpack565(color0, palette[0]);
+    bc1Unpack565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestError = 1 << 30;
+        for (int p = 0; p < 4; p++) {
+            int dr = pixels[i * 3] - palette[p][0], dg = pixels[i * 3 + 1] - palette[p][1];
+            int db = pixels[i * 3 + 2] - palette[p][2];
+            int error = dr * dr + dg * dg + db * db;
+            if (error < bestError) {
+                bestError = error;
+                best = p;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+    }
+    bc1WriteBlock(out, color0, color1, indices);
+}
+
+static inline int compressedChainAlloc(CompressedChain* chain, const int* width, const int* height, int levels) {
+    memset(chain, 0, sizeof(*chain));
+    chain->levels = levels;
+    for (int level = 0; level < levels; level++) {
+        chain->width[level] = width[level];
+        chain->height[level] = height[level];
+        chain->offset[level] = chain->totalSize;
+        chain->size[level] = (size_t)((width[level] + 3) / 4) * ((height[level] + 3) / 4) * BC1_BLOCK_BYTES;
+        chain->totalSize += chain->size[level];
+    }
+    chain->blocks = (unsigned char*)malloc(chain->totalSize);
+    return chain->blocks != NULL;
+}
+
+static inline void compressedChainFree(CompressedChain* chain) {
+    free(chain->blocks);
+    chain->blocks = NULL;
+}
+
+// Rzędy bloków [begin, end) w numeracji całego łańcucha (kolejne poziomy jeden za drugim)
+static inline void texCompressRows(void* arg, int begin, int end) {
+    const TexCompressJob* job = (const TexCompressJob*)arg;
+    const MipChain* source = job->source;
+    CompressedChain* chain = job->chain;
+    profilerBegin("kompresja BC1");
+    int level = 0;
+    for (int row = begin; row < end; row++) {
+        while (row >= job->firstRow[level + 1])
+            level++;
+        int width = source->width[level], height = source->height[level];
+        const unsigned char* pixels = source->pixels + source->offset[level];
+        int by = row - job->firstRow[level];
+        int blocksX = (width + 3) / 4;
+        unsigned char* out = chain->blocks + chain->offset[level] + (size_t)by * blocksX * BC1_BLOCK_BYTES;
+        for (int bx = 0; bx < blocksX; bx++) {
+            // Poziomy mniejsze niż 4x4 powielają ostatni wiersz / kolumnę
+            unsigned char block[16 * 3];
+            for (int y = 0; y < 4; y++) {
+                int py = by * 4 + y < height ? by * 4 + y : height - 1;
+                for (int x = 0; x < 4; x++) {
+                    int px = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                    memcpy(block + (y * 4 + x) * 3, pixels + ((size_t)py * width + px) * 3, 3);
+                }
+            }
+            bc1EncodeBlock(block, out + bx * BC1_BLOCK_BYTES);
+        }
+    }
+    profilerEnd();
+}
+
+// Zlecenie kodowania wszystkich poziomów source (bez czekania); zwraca 0 przy braku pamięci
+static inline int texCompressBegin(TexCompressJob* job, ThreadPool* pool, const MipChain* source, CompressedChain* chain) {
+    if (!compressedChainAlloc(chain, source->width, source->height, source->levels))
+        return 0;
+    job->source = source;
+    job->chain = chain;
+    job->firstRow[0] = 0;
+    for (int level = 0; level < source->levels; level++)
+        job->firstRow[level + 1] = job->firstRow[level] + (source->height[level] + 3) / 4;
+    threadPoolRun(pool, &job->task, texCompressRows, job, job->firstRow[source->levels], TEX_COMPRESS_ROWS_PER_CHUNK);
+    return 1;
+}
+
+static inline void texCompressEnd(TexCompressJob* job, ThreadPool* pool) {
+    threadPoolWait(pool, &job->task);
+}
+
+// Pamięć podręczna zakodowanych łańcuchów na dysku
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t width, height, levels;
+    uint32_t size;          // bajty bloków po nagłówku
+} TextureCacheHeader;
+
+typedef struct {
+    int enabled;
+    const char* dir;
+    int hits, misses;
+} TextureCache;
+
+static inline void textureCacheInit(TextureCache* cache, const char* dir, int enabled) {
+    memset(cache, 0, sizeof(*cache));
+    cache->dir = dir;
+    cache->enabled = enabled;
+    if (!enabled)
+        return;
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+}
+
+// Skrót wymiarów, liczby poziomów i pikseli poziomu 0 - pozostałe poziomy z niego wynikają
+static inline uint64_t textureCacheKey(const MipChain* source) {
+    int info[3] = { source->width[0], source->height[0], source->levels };
+    uint64_t hash = 14695981039346656037ULL;
+    hash = programCacheHashBytes(hash, (const char*)info, sizeof(info));
+    return programCacheHashBytes(hash, (const char*)source->pixels, (size_t)source->width[0] * source->height[0] * 3);
+}
+
+static inline void textureCachePath(const TextureCache* cache, uint64_t key, char* path, size_t size) {
+    snprintf(path, size, "%s/%016llx.bc1", cache->dir, (unsigned long long)key);
+}
+
+// Łańcuch z pliku (alokowany jak w texCompressBegin); 0 gdy go nie ma albo nie pasuje do source
+static inline int textureCacheLoad(TextureCache* cache, uint64_t key, const MipChain* source, CompressedChain* chain) {
+    if (!cache->enabled)
+        return 0;
+    char path[256];
+    textureCachePath(cache, key, path, sizeof(path));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        cache->misses++;
+        return 0;
+    }
+    TextureCacheHeader header;
+    int ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == TEXTURE_CACHE_MAGIC &&
+             header.version == TEXTURE_CACHE_VERSION && header.key == key &&
+             header.width == (uint32_t)source->width[0] && header.height == (uint32_t)source->height[0] &&
+             header.levels == (uint32_t)source->levels;
+    if (ok)
+        ok = compressedChainAlloc(chain, source->width, source->height, source->levels);
+    if (ok) {
+        ok = header.size == chain->totalSize && fread(chain->blocks, 1, chain->totalSize, file) == chain->totalSize;
+        if (!ok)
+            compressedChainFree(chain);
+    }
+    fclose(file);
+    if (ok)
+        cache->hits++;
+    else
+        cache->misses++;
+    return ok;
+}
+
+// Zapis łańcucha; błędy tylko wypisywane - tekstura działa i bez pliku
+static inline void textureCacheStore(const TextureCache* cache, uint64_t key, const CompressedChain* chain) {
+    if (!cache->enabled)
+        return;
+    TextureCacheHeader header;
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.key = key;
+    header.width = (uint32_t)chain->width[0];
+    header.height = (uint32_t)chain->height[0];
+    header.levels = (uint32_t)chain->levels;
+    header.size = (uint32_t)chain->totalSize;
+
+    char path[256];
+    textureCachePath(cache, key, path, sizeof(path));
+    FILE* file = fopen(path, "wb");
+    int ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(chain->blocks, 1, chain->totalSize, file) == chain->totalSize;
+    if (file)
+        fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Nie można zapisać tekstury do %s\n", path);
+        remove(path);
+    }
+}
+
+#endif
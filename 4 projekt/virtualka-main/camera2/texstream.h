@@ -0,0 +1,279 @@
+#ifndef TEXSTREAM_H
+#define TEXSTREAM_H
+
+// Strumieniowe wysyłanie tekstur w trakcie działania przez pierścień buforów PBO
+// (GL_PIXEL_UNPACK_BUFFER). Tekstura dzielona jest na paski wierszy mieszczące się w slocie;
+// wątki puli zapisują teksele paska prosto do zmapowanego bufora, a wątek renderowania tylko
+// zleca glTexSubImage z bufora i stawia płot (glFenceSync). Slot wraca do użytku, gdy płot
+// zostanie osiągnięty - sprawdzane bez czekania raz na klatkę, więc ani kopiowanie, ani
+// przesyłanie nie zatrzymuje klatki.
+// Poziomy mipmap też idą paskami (po całym poziomie 0 wszystkich warstw poziom 1 itd.), więc
+// po ostatnim pasku tekstura jest kompletna bez glGenerateMipmap w wątku renderowania.
+// Z GL_ARB_buffer_storage bufory są zmapowane na stałe (persistent + coherent), bez niego slot
+// mapowany jest przed zleceniem wypełnienia i odmapowywany przed glTexSubImage.
+// Wymaga wcześniejszego dołączenia glad.h, threadpool.h i profiler.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEX_STREAM_SLOTS 4
+#define TEX_STREAM_MAX_REQUESTS 8
+#define TEX_STREAM_ROWS_PER_CHUNK 16    // wierszy paska w jednym kawałku pracy wątku
+
+// Wypełnienie wierszy [begin, end) poziomu level warstwy layer tekstury RGB; wiersz begin trafia na początek dst
+typedef void (*TexStreamFill)(void* arg, int level, int layer, int begin, int end, unsigned char* dst);
+
+typedef struct {
+    GLuint texture;         // utworzona przez wywołującego (np. glTexImage z NULL)
+    GLenum target;          // GL_TEXTURE_2D albo GL_TEXTURE_2D_ARRAY
+    int width, height, layers;  // rozmiar poziomu 0
+    int levels;             // poziomy mipmap do przesłania (1 = tylko poziom 0), wszystkie utworzone przez wywołującego
+    TexStreamFill fill;
+    void* arg;
+    int nextLevel, nextLayer, nextRow;  // następny pasek do zlecenia
+    int bandsInFlight;      // paski zlecone, których przesyłanie jeszcze się nie skończyło
+} TexStreamRequest;
+
+enum TexStreamSlotState {
+    TEX_STREAM_FREE,
+    TEX_STREAM_FILLING,     // wątki puli zapisują pasek do bufora
+    TEX_STREAM_UPLOADING    // glTexSubImage zlecone, płot jeszcze nieosiągnięty
+};
+
+typedef struct {
+    GLuint buffer;
+    unsigned char* mapped;  // NULL gdy niezmapowany
+    GLsync fence;
+    int state;
+    TexStreamRequest* request;
+    int level, layer, row, rows;
+    ThreadPoolTask task;
+} TexStreamSlot;
+
+typedef struct {
+    int supported;
+    int persistent;
+    size_t slotBytes;
+    TexStreamSlot slots[TEX_STREAM_SLOTS];
+    TexStreamRequest* requests[TEX_STREAM_MAX_REQUESTS];
+    int numRequests;
+    size_t uploadedBytes;
+} TexStream;
+
+// Płoty są od OpenGL 3.2 (GL_ARB_sync), mapowanie zakresu od 3.0 (GL_ARB_map_buffer_range)
+static inline int texStreamSupported(void) {
+    return (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync) && (GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_map_buffer_range);
+}
+
+// Stan pusty pole po polu - sloty zawierają atomowe liczniki zadań, więc bez memset
+static inline void texStreamReset(TexStream* stream, size_t slotBytes) {
+    stream->supported = stream->persistent = 0;
+    stream->slotBytes = slotBytes;
+    for (int i = 0; i < TEX_STREAM_SLOTS; i++) {
+        TexStreamSlot* slot = &stream->slots[i];
+        slot->buffer = 0;
+        slot->mapped = NULL;
+        slot->fence = 0;
+        slot->state = TEX_STREAM_FREE;
+        slot->request = NULL;
+        slot->level = slot->layer = slot->row = slot->rows = 0;
+    }
+    stream->numRequests = 0;
+    stream->uploadedBytes = 0;
+}
+
+// Płoty, mapowania i bufory (bez czekania na wątki)
+static inline void texStreamFreeBuffers(TexStream* stream) {
+    for (int i = 0; i < TEX_STREAM_SLOTS; i++) {
+        TexStreamSlot* slot = &stream->slots[i];
+        if (slot->fence)
+            glDeleteSync(slot->fence);
+        if (slot->mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        if (slot->buffer)
+            glDeleteBuffers(1, &slot->buffer);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    texStreamReset(stream, stream->slotBytes);
+}
+
+// Po załadowaniu funkcji GL; zwraca 0 (i strumień jest nieaktywny) bez potrzebnych rozszerzeń
+static inline int texStreamInit(TexStream* stream, size_t slotBytes) {
+    texStreamReset(stream, slotBytes);
+    if (!texStreamSupported()) {
+        fprintf(stderr, "Brak GL_ARB_sync / GL_ARB_map_buffer_range - strumieniowanie tekstur wyłączone\n");
+        return 0;
+    }
+    stream->supported = 1;
+    stream->persistent = GLAD_GL_ARB_buffer_storage;
+    for (int i = 0; i < TEX_STREAM_SLOTS; i++) {
+        TexStreamSlot* slot = &stream->slots[i];
+        glGenBuffers(1, &slot->buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+        if (stream->persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)slotBytes, NULL, flags);
+            slot->mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)slotBytes, flags);
+            if (!slot->mapped) {
+                fprintf(stderr, "Nie można zmapować bufora strumienia tekstur - strumieniowanie wyłączone\n");
+                texStreamFreeBuffers(stream);
+                return 0;
+            }
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)slotBytes, NULL, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return 1;
+}
+
+// Dołączenie żądania; request musi żyć do texStreamRequestDone. Zwraca 0 gdy kolejka jest pełna.
+static inline int texStreamSubmit(TexStream* stream, TexStreamRequest* request) {
+    if (!stream->supported || stream->numRequests == TEX_STREAM_MAX_REQUESTS)
+        return 0;
+    if (request->levels < 1)
+        request->levels = 1;
+    request->nextLevel = request->nextLayer = request->nextRow = 0;
+    request->bandsInFlight = 0;
+    stream->requests[stream->numRequests++] = request;
+    return 1;
+}
+
+static inline int texStreamRequestDone(const TexStreamRequest* request) {
+    return request->nextLevel == request->levels && request->bandsInFlight == 0;
+}
+
+// Wymiar poziomu mipmap jak w OpenGL: połowa poprzedniego, nie mniej niż 1
+static inline int texStreamLevelSize(int size, int level) {
+    return size >> level > 0 ? size >> level : 1;
+}
+
+static inline void texStreamFillRows(void* arg, int begin, int end) {
+    TexStreamSlot* slot = (TexStreamSlot*)arg;
+    const TexStreamRequest* request = slot->request;
+    size_t rowBytes = (size_t)texStreamLevelSize(request->width, slot->level) * 3;
+    profilerBegin("paski tekstur");
+    request->fill(request->arg, slot->level, slot->layer, slot->row + begin, slot->row + end,
+                  slot->mapped + begin * rowBytes);
+    profilerEnd();
+}
+
+// Wypełniony pasek do tekstury: odczyt z bufora (przesunięcie 0) i płot za nim
+static inline void texStreamUploadSlot(TexStream* stream, TexStreamSlot* slot) {
+    const TexStreamRequest* request = slot->request;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+    if (!stream->persistent) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        slot->mapped = NULL;
+    }
+    int width = texStreamLevelSize(request->width, slot->level);
+    glBindTexture(request->target, request->texture);
+    if (request->target == GL_TEXTURE_2D_ARRAY)
+        glTexSubImage3D(request->target, slot->level, 0, slot->row, slot->layer, width, slot->rows, 1, GL_RGB,
+                        GL_UNSIGNED_BYTE, (const void*)0);
+    else
+        glTexSubImage2D(request->target, slot->level, 0, slot->row, width, slot->rows, GL_RGB, GL_UNSIGNED_BYTE,
+                        (const void*)0);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->state = TEX_STREAM_UPLOADING;
+    stream->uploadedBytes += (size_t)width * slot->rows * 3;
+}
+
+// Następny pasek pierwszego żądania z niezleconymi wierszami do wolnego slotu
+static inline void texStreamFillSlot(TexStream* stream, ThreadPool* pool, TexStreamSlot* slot) {
+    TexStreamRequest* request = NULL;
+    for (int i = 0; i < stream->numRequests && !request; i++) {
+        if (stream->requests[i]->nextLevel < stream->requests[i]->levels)
+            request = stream->requests[i];
+    }
+    if (!request)
+        return;
+    int width = texStreamLevelSize(request->width, request->nextLevel);
+    int height = texStreamLevelSize(request->height, request->nextLevel);
+    size_t rowBytes = (size_t)width * 3;
+    int rows = (int)(stream->slotBytes / rowBytes);
+    if (rows < 1) {
+        fprintf(stderr, "Wiersz tekstury (%d pikseli) nie mieści się w buforze strumienia\n", width);
+        request->nextLevel = request->levels;   // żądanie porzucone
+        return;
+    }
+    if (rows > height - request->nextRow)
+        rows = height - request->nextRow;
+    if (!stream->persistent) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+        // Poprzednie przesyłanie z tego slotu już się skończyło (płot), więc bez synchronizacji
+        slot->mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)(rows * rowBytes),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!slot->mapped)
+            return;
+    }
+    slot->request = request;
+    slot->level = request->nextLevel;
+    slot->layer = request->nextLayer;
+    slot->row = request->nextRow;
+    slot->rows = rows;
+    slot->state = TEX_STREAM_FILLING;
+    request->bandsInFlight++;
+    request->nextRow += rows;
+    if (request->nextRow == height) {
+        request->nextRow = 0;
+        if (++request->nextLayer == request->layers) {
+            request->nextLayer = 0;
+            request->nextLevel++;
+        }
+    }
+    threadPoolRun(pool, &slot->task, texStreamFillRows, slot, rows, TEX_STREAM_ROWS_PER_CHUNK);
+}
+
+// Raz na klatkę z wątku renderowania: przesłanie wypełnionych pasków, zwolnienie slotów
+// z osiągniętym płotem i zlecenie kolejnych pasków. Nigdy nie czeka na GPU ani na wątki.
+static inline void texStreamUpdate(TexStream* stream, ThreadPool* pool) {
+    if (!stream->supported || stream->numRequests == 0)
+        return;
+    profilerBegin("strumien tekstur");
+    // Wiersze RGB nie są wyrównane do 4 bajtów dla szerokości niepodzielnych przez 4
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < TEX_STREAM_SLOTS; i++) {
+        TexStreamSlot* slot = &stream->slots[i];
+        if (slot->state == TEX_STREAM_UPLOADING) {
+            GLenum status = glClientWaitSync(slot->fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                glDeleteSync(slot->fence);
+                slot->fence = 0;
+                slot->request->bandsInFlight--;
+                slot->state = TEX_STREAM_FREE;
+            }
+        } else if (slot->state == TEX_STREAM_FILLING && (threadPoolDone(&slot->task) || pool->numWorkers == 0)) {
+            // Zwykle tylko zdjęcie zadania z kolejki; bez wątków roboczych pasek wypełnia się tutaj
+            threadPoolWait(pool, &slot->task);
+            texStreamUploadSlot(stream, slot);
+        }
+        if (slot->state == TEX_STREAM_FREE)
+            texStreamFillSlot(stream, pool, slot);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // Zakończone żądania wypadają z kolejki - wywołujący sprawdza je przez texStreamRequestDone
+    int kept = 0;
+    for (int i = 0; i < stream->numRequests; i++) {
+        if (!texStreamRequestDone(stream->requests[i]))
+            stream->requests[kept++] = stream->requests[i];
+    }
+    stream->numRequests = kept;
+    profilerEnd();
+}
+
+static inline void texStreamFree(TexStream* stream, ThreadPool* pool) {
+    if (!stream->supported)
+        return;
+    for (int i = 0; i < TEX_STREAM_SLOTS; i++) {
+        if (stream->slots[i].state == TEX_STREAM_FILLING)
+            threadPoolWait(pool, &stream->slots[i].task);
+    }
+    texStreamFreeBuffers(stream);
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef TEXSYNTH_H
+#define TEXSYNTH_H
+
+// Synteza tekstur proceduralnych (szachownice RGB) na wątkach puli.
+// Wzór zależy tylko od parzystości pola w wierszu i kolumnie, więc są tylko dwa różne wiersze:
+// oba budowane są raz (odcinek 32 pikseli, potem podwajany memcpy), a każdy wiersz tekstury to
+// jedna kopia gotowego wiersza - bez dzielenia, modulo i switch na piksel. memcpy z biblioteki
+// standardowej kopiuje wektorowo (SSE/AVX), a wiersze dzielone są między wątki.
+// Wymaga threadpool.h i profiler.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#define TEXSYNTH_CELL_SHIFT 5       // pole szachownicy 32x32 piksele
+#define TEXSYNTH_ROWS_PER_CHUNK 16  // wierszy w jednym kawałku pracy wątku
+
+typedef struct {
+    unsigned char even[3];  // kolor pól o parzystej sumie (x / 32 + y / 32)
+    unsigned char odd[3];
+} TexturePattern;
+
+// Wzory jak w dotychczasowym createProceduralTexture (check = 1 dla pól nieparzystych) i kolor słońca
+enum TexturePatternType {
+    PATTERN_BLACK_WHITE, PATTERN_RED_BLUE, PATTERN_GREEN_YELLOW, PATTERN_BLUE_VIOLET, PATTERN_ORANGE_PINK,
+    PATTERN_YELLOW,
+    PATTERN_COUNT
+};
+static const TexturePattern texturePatterns[PATTERN_COUNT] = {
+    { {   0,   0,   0 }, { 255, 255, 255 } },   // Szachownica czarno-biała
+    { {   0,   0, 255 }, { 255,   0,   0 } },   // Czerwono-niebieska
+    { {   0, 255, 128 }, { 255, 255,   0 } },   // Zielono-żółta
+    { {   0,   0, 255 }, { 128,   0, 255 } },   // Niebiesko-fioletowa
+    { { 255,   0, 200 }, { 255, 128,   0 } },   // Pomarańczowo-różowa
+    { { 255, 255,   0 }, { 255, 255,   0 } },   // Żółta (słońce)
+};
+
+typedef struct {
+    int width, height;
+    unsigned char* pixels;  // width * height * 3, wiersze bez wyrównania
+    unsigned char* rows[2]; // wiersz zaczynający się polem parzystym / nieparzystym
+    int cellShift;          // log2 boku pola (mniejszy na poziomach mipmap)
+    ThreadPoolTask task;
+} TextureSynthesis;
+
+// Wiersz wzoru zaczynający się kolorem first: jeden odcinek pola, potem kopie podwajane
+static inline void texSynthBuildRow(unsigned char* row, int width, int cellShift, const unsigned char* first,
+                                    const unsigned char* second) {
+    int cell = 1 << cellShift;
+    int cellBytes = cell * 3;
+    int rowBytes = width * 3;
+    for (int x = 0; x < cell && x < width; x++)
+        memcpy(row + x * 3, first, 3);
+    for (int x = 0; x < cell && cell + x < width; x++)
+        memcpy(row + (cell + x) * 3, second, 3);
+    for (int filled = 2 * cellBytes; filled < rowBytes; filled *= 2) {
+        int copy = filled < rowBytes - filled ? filled : rowBytes - filled;
+        memcpy(row + filled, row, copy);
+    }
+}
+
+// Wiersze [begin, end) wzoru do dst (wiersz begin na początku dst) - np. prosto do zmapowanego bufora PBO
+static inline void texSynthCopyRows(const TextureSynthesis* synth, int begin, int end, unsigned char* dst) {
+    size_t rowBytes = (size_t)synth->width * 3;
+    for (int y = begin; y < end; y++)
+        memcpy(dst + (size_t)(y - begin) * rowBytes, synth->rows[(y >> synth->cellShift) & 1], rowBytes);
+}
+
+static inline void texSynthRows(void* arg, int begin, int end) {
+    TextureSynthesis* synth = (TextureSynthesis*)arg;
+    profilerBegin("synteza tekstury");
+    texSynthCopyRows(synth, begin, end, synth->pixels + (size_t)begin * synth->width * 3);
+    profilerEnd();
+}
+
+// Dwa wiersze poziomu level mipmap wzoru o rozmiarze width x height, bez syntezy całej tekstury
+// (pixels = NULL) - wiersze kopiuje potem texSynthCopyRows. Do poziomu TEXSYNTH_CELL_SHIFT pole
+// maleje o połowę, a każdy teksel leży w jednym polu; dalej każdy teksel obejmuje po równo pola
+// obu kolorów, więc poziom jest jednolity. Dla rozmiarów będących potęgą dwójki wynik jest taki
+// sam jak z filtra pudełkowego mipmap.h. Zwraca 0 przy braku pamięci.
+static inline int texSynthPrepareLevel(TextureSynthesis* synth, const TexturePattern* pattern, int width, int height,
+                                       int level) {
+    width = width >> level > 0 ? width >> level : 1;
+    height = height >> level > 0 ? height >> level : 1;
+    synth->width = width;
+    synth->height = height;
+    synth->pixels = NULL;
+    synth->rows[0] = (unsigned char*)malloc((size_t)width * 3 * 2);
+    if (!synth->rows[0])
+        return 0;
+    synth->rows[1] = synth->rows[0] + (size_t)width * 3;
+    if (level <= TEXSYNTH_CELL_SHIFT) {
+        synth->cellShift = TEXSYNTH_CELL_SHIFT - level;
+        texSynthBuildRow(synth->rows[0], width, synth->cellShift, pattern->even, pattern->odd);
+        texSynthBuildRow(synth->rows[1], width, synth->cellShift, pattern->odd, pattern->even);
+    } else {
+        unsigned char mean[3];
+        for (int c = 0; c < 3; c++)
+            mean[c] = (unsigned char)((pattern->even[c] + pattern->odd[c] + 1) >> 1);
+        synth->cellShift = 0;
+        texSynthBuildRow(synth->rows[0], width, 0, mean, mean);
+        texSynthBuildRow(synth->rows[1], width, 0, mean, mean);
+    }
+    return 1;
+}
+
+// Dwa wiersze wzoru (poziom 0) - patrz texSynthPrepareLevel
+static inline int texSynthPrepare(TextureSynthesis* synth, const TexturePattern* pattern, int width, int height) {
+    return texSynthPrepareLevel(synth, pattern, width, height, 0);
+}
+
+static inline void texSynthRelease(TextureSynthesis* synth) {
+    free(synth->rows[0]);
+    synth->rows[0] = synth->rows[1] = NULL;
+}
+
+// Zlecenie syntezy (bez czekania); pixels - bufor width * height * 3. Zwraca 0 przy braku pamięci.
+static inline int texSynthBegin(TextureSynthesis* synth, ThreadPool* pool, const TexturePattern* pattern,
+                                int width, int height, unsigned char* pixels) {
+    if (!texSynthPrepare(synth, pattern, width, height))
+        return 0;
+    synth->pixels = pixels;
+    threadPoolRun(pool, &synth->task, texSynthRows, synth, height, TEXSYNTH_ROWS_PER_CHUNK);
+    return 1;
+}
+
+// Dokończenie syntezy - wątek wywołujący pomaga w pracy
+static inline void texSynthEnd(TextureSynthesis* synth, ThreadPool* pool) {
+    threadPoolWait(pool, &synth->task);
+    texSynthRelease(synth);
+}
+
+static inline int texSynthGenerate(ThreadPool* pool, const TexturePattern* pattern, int width, int height,
+                                   unsigned char* pixels) {
+    TextureSynthesis synth;
+    if (!texSynthBegin(&synth, pool, pattern, width, height, pixels))
+        return 0;
+    texSynthEnd(&synth, pool);
+    return 1;
+}
+
+// Dotychczasowa pętla piksel po pikselu - punkt odniesienia dla pomiaru i sprawdzenia wyniku
+static inline void texSynthReference(const TexturePattern* pattern, int width, int height, unsigned char* pixels) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int check = ((x / 32) + (y / 32)) % 2;
+            const unsigned char* color = check ? pattern->odd : pattern->even;
+            int index = (y * width + x) * 3;
+            pixels[index + 0] = color[0];
+            pixels[index + 1] = color[1];
+            pixels[index + 2] = color[2];
+        }
+    }
+}
+
+// Pomiar czasu syntezy na megapiksel: pętla odniesienia, jeden wątek i cała pula.
+// Zwraca 0 gdy wyniki się różnią albo zabrakło pamięci.
+static inline int texSynthBenchmark(ThreadPool* pool, int size, int repeats) {
+    size_t bytes = (size_t)size * size * 3;
+    unsigned char* reference = (unsigned char*)malloc(bytes);
+    unsigned char* pixels = (unsigned char*)malloc(bytes);
+    if (!reference || !pixels) {
+        fprintf(stderr, "Brak pamięci na teksturę %dx%d\n", size, size);
+        free(reference);
+        free(pixels);
+        return 0;
+    }
+    ThreadPool single;
+    threadPoolInit(&single, 0);     // brak wątków roboczych - wszystko w wątku wywołującym
+    double megapixels = (double)size * size / 1e6;
+    double best[3] = { 1e30, 1e30, 1e30 };
+    int ok = 1;
+    for (int r = 0; r < repeats; r++) {
+        for (int variant = 0; variant < 3; variant++) {
+            const TexturePattern* pattern = &texturePatterns[r % PATTERN_COUNT];
+            auto start = std::chrono::steady_clock::now();
+            if (variant == 0)
+                texSynthReference(pattern, size, size, reference);
+            else
+                ok &= texSynthGenerate(variant == 1 ? &single : pool, pattern, size, size, pixels);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (ms < best[variant])
+                best[variant] = ms;
+        }
+        ok &= memcmp(reference, pixels, bytes) == 0;
+    }
+    threadPoolFree(&single);
+    printf("Synteza tekstury %dx%d (%.1f Mpx), najlepszy z %d przebiegów:\n", size, size, megapixels, repeats);
+    printf("  piksel po pikselu:      %8.3f ms (%.3f ms/Mpx)\n", best[0], best[0] / megapixels);
+    printf("  wiersze, 1 wątek:       %8.3f ms (%.3f ms/Mpx)\n", best[1], best[1] / megapixels);
+    printf("  wiersze, wątków: %2d:    %8.3f ms (%.3f ms/Mpx)\n", pool->numWorkers + 1, best[2], best[2] / megapixels);
+    printf("  wynik %s\n", ok ? "identyczny z pętlą piksel po pikselu" : "RÓŻNY od pętli piksel po pikselu");
+    free(reference);
+    free(pixels);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Pula wątków roboczych do pracy dzielonej na zakresy (wiersze tekstury, bloki, poziomy mipmap,
+// macierze obiektów).
+// Zadanie (ThreadPoolTask) to funkcja wywoływana dla kolejnych kawałków [begin, end) zakresu
+// [0, count); wątki pobierają kawałki z licznika atomowego, więc nierówna praca rozkłada się sama.
+// threadPoolRun tylko kolejkuje zadanie - wątek główny może w tym czasie robić co innego,
+// a threadPoolWait dołącza się do pracy i wraca, gdy całe zadanie jest wykonane.
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define THREAD_POOL_MAX_WORKERS 16
+#define THREAD_POOL_MAX_TASKS 64    // zadań czekających jednocześnie w kolejce
+
+typedef void (*ThreadPoolFunction)(void* arg, int begin, int end);
+
+typedef struct {
+    ThreadPoolFunction function;
+    void* arg;
+    int count;              // liczba elementów (np. wierszy)
+    int grain;              // elementów w jednym kawałku
+    std::atomic<int> next;  // pierwszy jeszcze nie pobrany element
+    std::atomic<int> done;  // elementów już wykonanych
+    int workers;            // wątki robocze w trakcie pracy nad zadaniem (pod blokadą puli)
+} ThreadPoolTask;
+
+typedef struct {
+    std::thread workers[THREAD_POOL_MAX_WORKERS];
+    int numWorkers;
+    std::mutex mutex;
+    std::condition_variable wake;       // nowe zadanie albo zamknięcie puli
+    std::condition_variable finished;   // któreś zadanie się skończyło
+    ThreadPoolTask* queue[THREAD_POOL_MAX_TASKS];
+    int head, count;
+    int quit;
+} ThreadPool;
+
+// Wykonuje jeden kawałek zadania; zwraca 0 gdy nie było już nic do pobrania
+static inline int threadPoolRunChunk(ThreadPool* pool, ThreadPoolTask* task) {
+    int begin = task->next.fetch_add(task->grain);
+    if (begin >= task->count)
+        return 0;
+    int end = begin + task->grain < task->count ? begin + task->grain : task->count;
+    task->function(task->arg, begin, end);
+    if (task->done.fetch_add(end - begin) + (end - begin) == task->count) {
+        // Blokada, żeby powiadomienie nie rozminęło się z czekającym w threadPoolWait
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->finished.notify_all();
+    }
+    return 1;
+}
+
+static inline void threadPoolWorker(ThreadPool* pool) {
+    for (;;) {
+        ThreadPoolTask* task;
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [pool] { return pool->quit || pool->count > 0; });
+            if (pool->count == 0)
+                return;     // quit i pusta kolejka
+            task = pool->queue[pool->head];
+            // Wszystkie kawałki już pobrane - zadanie znika z kolejki, reszta kończy się u innych
+            if (task->next.load() >= task->count) {
+                pool->head = (pool->head + 1) % THREAD_POOL_MAX_TASKS;
+                pool->count--;
+                continue;
+            }
+            task->workers++;
+        }
+        while (threadPoolRunChunk(pool, task)) {}
+        // Dopiero gdy żaden wątek nie używa zadania, threadPoolWait może wrócić (i zwolnić zadanie)
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--task->workers == 0)
+            pool->finished.notify_all();
+    }
+}
+
+// numWorkers < 0 - o jeden mniej niż rdzeni (wątek główny też pracuje w threadPoolWait),
+// 0 - bez wątków, całą pracę wykonuje wątek wywołujący threadPoolWait
+static inline void threadPoolInit(ThreadPool* pool, int numWorkers) {
+    if (numWorkers < 0)
+        numWorkers = (int)std::thread::hardware_concurrency() - 1;
+    if (numWorkers > THREAD_POOL_MAX_WORKERS)
+        numWorkers = THREAD_POOL_MAX_WORKERS;
+    pool->head = pool->count = 0;
+    pool->quit = 0;
+    pool->numWorkers = 0;
+    for (int i = 0; i < numWorkers; i++)
+        pool->workers[pool->numWorkers++] = std::thread(threadPoolWorker, pool);
+}
+
+static inline void threadPoolFree(ThreadPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = 1;
+    }
+    pool->wake.notify_all();
+    for (int i = 0; i < pool->numWorkers; i++)
+        pool->workers[i].join();
+    pool->numWorkers = 0;
+}
+
+// Kolejkuje zadanie bez czekania; task musi żyć do zakończenia threadPoolWait
+static inline void threadPoolRun(ThreadPool* pool, ThreadPoolTask* task, ThreadPoolFunction function, void* arg,
+                                 int count, int grain) {
+    task->function = function;
+    task->arg = arg;
+    task->count = count;
+    task->grain = grain > 0 ? grain : 1;
+    task->next.store(0);
+    task->done.store(0);
+    task->workers = 0;
+    if (count <= 0 || pool->numWorkers == 0)
+        return;     // bez wątków całą pracę wykona threadPoolWait
+    int queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (pool->count < THREAD_POOL_MAX_TASKS) {
+            pool->queue[(pool->head + pool->count) % THREAD_POOL_MAX_TASKS] = task;
+            pool->count++;
+            queued = 1;
+        }
+    }
+    if (queued)
+        pool->wake.notify_all();
+}
+
+// Czy zadanie jest już wykonane (bez czekania)
+static inline int threadPoolDone(const ThreadPoolTask* task) {
+    return task->done.load() >= task->count;
+}
+
+// Wątek wywołujący wykonuje pozostałe kawałki, po czym czeka na kawałki w toku u innych wątków
+static inline void threadPoolWait(ThreadPool* pool, ThreadPoolTask* task) {
+    while (threadPoolRunChunk(pool, task)) {}
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->finished.wait(lock, [task] { return threadPoolDone(task) && task->workers == 0; });
+    // Zadanie mogło zostać w kolejce, jeśli żaden wątek nie zdążył go z niej zdjąć
+    for (int i = 0; i < pool->count; i++) {
+        if (pool->queue[(pool->head + i) % THREAD_POOL_MAX_TASKS] != task)
+            continue;
+        for (int j = i; j + 1 < pool->count; j++)
+            pool->queue[(pool->head + j) % THREAD_POOL_MAX_TASKS] = pool->queue[(pool->head + j + 1) % THREAD_POOL_MAX_TASKS];
+        pool->count--;
+        break;
+    }
+}
+
+// Równoległa pętla - kolejkowanie i czekanie naraz
+static inline void threadPoolFor(ThreadPool* pool, ThreadPoolFunction function, void* arg, int count, int grain) {
+    ThreadPoolTask task;
+    threadPoolRun(pool, &task, function, arg, count, grain);
+    threadPoolWait(pool, &task);
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Tryb bez okna do pomiarów na maszynach bez GPU i monitora (np. Mesa llvmpipe na serwerze CI).
+// Na Linuksie bez DISPLAY/WAYLAND_DISPLAY używana jest platforma "null" GLFW z kontekstem OSMesa,
+// w pozostałych przypadkach niewidoczne okno. Obraz trafia do FBO o stałym rozmiarze, vsync jest
+// wyłączony, a po zadanej liczbie klatek wypisywane są czasy CPU i GPU każdej klatki.
+// Wymaga wcześniejszego dołączenia glad.h i glfw3.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADLESS_DEFAULT_FRAMES 500
+#define HEADLESS_QUERY_RING 4   // tyle klatek wstecz odczytujemy wynik zapytania - bez czekania na GPU
+
+typedef struct {
+    int enabled;
+    int frames;                 // liczba klatek do narysowania
+    int width, height;          // rozmiar FBO
+    int frame;                  // numer bieżącej klatki
+    int nullPlatform;           // 1 = platforma null GLFW + OSMesa
+    GLuint fbo, colorBuffer, depthBuffer;
+    GLuint queries[HEADLESS_QUERY_RING];
+    int timerQueries;           // 1 gdy dostępne GL_TIME_ELAPSED
+    double frameStart;
+    double* cpuMs;
+    double* gpuMs;              // < 0 gdy brak pomiaru
+} Headless;
+
+static inline void headlessInit(Headless* headless) {
+    memset(headless, 0, sizeof(*headless));
+    headless->frames = HEADLESS_DEFAULT_FRAMES;
+    headless->width = 1024;
+    headless->height = 768;
+}
+
+// Przed glfwInit - wybór platformy
+static inline void headlessPrepareGlfw(Headless* headless) {
+    if (!headless->enabled)
+        return;
+#if defined(__linux__)
+    if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY")) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        headless->nullPlatform = 1;
+    }
+#endif
+}
+
+// Po pozostałych glfwWindowHint, przed glfwCreateWindow
+static inline void headlessWindowHints(const Headless* headless) {
+    if (!headless->enabled)
+        return;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    if (headless->nullPlatform)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+}
+
+// Po załadowaniu funkcji GL - FBO, zapytania czasu GPU i tablice wyników
+static inline void headlessCreateTarget(Headless* headless) {
+    if (!headless->enabled)
+        return;
+    headless->cpuMs = (double*)malloc(sizeof(double) * headless->frames);
+    headless->gpuMs = (double*)malloc(sizeof(double) * headless->frames);
+    if (!headless->cpuMs || !headless->gpuMs) {
+        fprintf(stderr, "Brak pamięci na wyniki pomiarów\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < headless->frames; i++)
+        headless->gpuMs[i] = -1.0;
+
+    if (GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_framebuffer_object) {
+        glGenRenderbuffers(1, &headless->colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, headless->colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headless->width, headless->height);
+        glGenRenderbuffers(1, &headless->depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, headless->depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, headless->width, headless->height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &headless->fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "FBO niekompletny - rysowanie do domyślnego bufora okna\n");
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &headless->fbo);
+            glDeleteRenderbuffers(1, &headless->colorBuffer);
+            glDeleteRenderbuffers(1, &headless->depthBuffer);
+            headless->fbo = headless->colorBuffer = headless->depthBuffer = 0;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    } else {
+        fprintf(stderr, "Brak obsługi FBO - rysowanie do domyślnego bufora okna\n");
+    }
+
+    headless->timerQueries = GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_timer_query;
+    if (headless->timerQueries) {
+        glGenQueries(HEADLESS_QUERY_RING, headless->queries);
+        // Pierwsze zapytanie z rysowaniem zwraca na llvmpipe śmieci - jedno na rozgrzewkę
+        GLuint64 elapsed = 0;
+        glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+        glBeginQuery(GL_TIME_ELAPSED, headless->queries[0]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glEndQuery(GL_TIME_ELAPSED);
+        glGetQueryObjectui64v(headless->queries[0], GL_QUERY_RESULT, &elapsed);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    } else
+        fprintf(stderr, "Brak GL_TIME_ELAPSED - czasy GPU nie będą mierzone\n");
+}
+
+static inline void headlessFramebufferSize(const Headless* headless, GLFWwindow* window, int* width, int* height) {
+    if (headless->enabled && headless->fbo) {
+        *width = headless->width;
+        *height = headless->height;
+    } else {
+        glfwGetFramebufferSize(window, width, height);
+    }
+}
+
+// Odczyt wyniku zapytania klatki frame (blokuje tylko gdy GPU jeszcze nie skończyło)
+static inline void headlessCollectQuery(Headless* headless, int frame) {
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(headless->queries[frame % HEADLESS_QUERY_RING], GL_QUERY_RESULT, &elapsed);
+    headless->gpuMs[frame] = (double)elapsed / 1.0e6;
+}
+
+// Na początku klatki, przed pierwszym glClear
+static inline void headlessBeginFrame(Headless* headless) {
+    if (!headless->enabled)
+        return;
+    headless->frameStart = glfwGetTime();
+    if (headless->fbo)
+        glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+    if (headless->timerQueries) {
+        // Zapytanie sprzed HEADLESS_QUERY_RING klatek jest już zwykle gotowe
+        if (headless->frame >= HEADLESS_QUERY_RING)
+            headlessCollectQuery(headless, headless->frame - HEADLESS_QUERY_RING);
+        glBeginQuery(GL_TIME_ELAPSED, headless->queries[headless->frame % HEADLESS_QUERY_RING]);
+    }
+}
+
+// Na końcu klatki, po glfwSwapBuffers i glfwPollEvents
+static inline void headlessEndFrame(Headless* headless, GLFWwindow* window) {
+    if (!headless->enabled)
+        return;
+    if (headless->timerQueries)
+        glEndQuery(GL_TIME_ELAPSED);
+    headless->cpuMs[headless->frame] = (glfwGetTime() - headless->frameStart) * 1000.0;
+    headless->frame++;
+    if (headless->frame >= headless->frames)
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+}
+
+// Po wyjściu z pętli - czasy klatek i podsumowanie na stdout, zwolnienie zasobów
+static inline void headlessReport(Headless* headless) {
+    if (!headless->enabled)
+        return;
+    int frames = headless->frame;
+    if (headless->timerQueries) {
+        int first = frames > HEADLESS_QUERY_RING ? frames - HEADLESS_QUERY_RING : 0;
+        for (int i = first; i < frames; i++)
+            headlessCollectQuery(headless, i);
+    }
+
+    double cpuSum = 0.0, gpuSum = 0.0, cpuMax = 0.0, gpuMax = 0.0;
+    printf("klatka;cpu_ms;gpu_ms\n");
+    for (int i = 0; i < frames; i++) {
+        printf("%d;%.3f;%.3f\n", i, headless->cpuMs[i], headless->gpuMs[i]);
+        cpuSum += headless->cpuMs[i];
+        gpuSum += headless->gpuMs[i];
+        if (headless->cpuMs[i] > cpuMax) cpuMax = headless->cpuMs[i];
+        if (headless->gpuMs[i] > gpuMax) gpuMax = headless->gpuMs[i];
+    }
+    if (frames > 0) {
+        printf("Klatek: %d (%dx%d), CPU: średnio %.3f ms, maks. %.3f ms", frames,
+               headless->width, headless->height, cpuSum / frames, cpuMax);
+        if (headless->timerQueries)
+            printf(", GPU: średnio %.3f ms, maks. %.3f ms", gpuSum / frames, gpuMax);
+        printf("\n");
+    }
+
+    if (headless->timerQueries)
+        glDeleteQueries(HEADLESS_QUERY_RING, headless->queries);
+    if (headless->fbo) {
+        glDeleteFramebuffers(1, &headless->fbo);
+        glDeleteRenderbuffers(1, &headless->colorBuffer);
+        glDeleteRenderbuffers(1, &headless->depthBuffer);
+    }
+    free(headless->cpuMs);
+    free(headless->gpuMs);
+    headless->cpuMs = headless->gpuMs = NULL;
+}
+
+#endif
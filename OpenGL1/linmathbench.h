@@ -0,0 +1,118 @@
+#ifndef LINMATHBENCH_H
+#define LINMATHBENCH_H
+
+// Pomiar linmath.h bez okna (--linmath-bench): stare pętle skalarne (mat4x4_*_scalar) kontra
+// wersje SIMD wybrane przy kompilacji, na paczce wielu macierzy. Przy milionie macierzy dane
+// (64 MB na tablicę) nie mieszczą się w pamięci podręcznej, więc wynik obejmuje też odczyt z RAM -
+// tak jak wsadowe liczenie macierzy wszystkich obiektów w klatce.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include "linmath.h"
+
+enum LinmathBenchOp {
+    LINMATH_BENCH_MUL,       // mat4x4_mul(out, PV, in) - jak MVP = PV * M
+    LINMATH_BENCH_MUL_VEC4,  // mat4x4_mul_vec4(out, in, v)
+    LINMATH_BENCH_INVERT,    // mat4x4_invert(out, in)
+    LINMATH_BENCH_OP_COUNT
+};
+
+static const char* const linmathBenchOpNames[LINMATH_BENCH_OP_COUNT] = {
+    "mat4x4_mul", "mat4x4_mul_vec4", "mat4x4_invert"
+};
+
+static inline const char* linmathSimdName() {
+#if defined(LINMATH_SIMD_FMA)
+    return "AVX2 (FMA)";
+#elif defined(LINMATH_SIMD_AVX)
+    return "AVX";
+#elif defined(LINMATH_SIMD_SSE)
+    return "SSE";
+#else
+    return "brak (pętle skalarne)";
+#endif
+}
+
+// Jeden przebieg operacji op po wszystkich macierzach; wynik mnożenia przez wektor trafia do out[i][0]
+static inline void linmathBenchPass(int op, int simd, const mat4x4* in, mat4x4* out, int count, mat4x4 PV, vec4 v) {
+    switch (op) {
+    case LINMATH_BENCH_MUL:
+        if (simd) for (int i = 0; i < count; i++) mat4x4_mul(out[i], PV, in[i]);
+        else      for (int i = 0; i < count; i++) mat4x4_mul_scalar(out[i], PV, in[i]);
+        break;
+    case LINMATH_BENCH_MUL_VEC4:
+        if (simd) for (int i = 0; i < count; i++) mat4x4_mul_vec4(out[i][0], in[i], v);
+        else      for (int i = 0; i < count; i++) mat4x4_mul_vec4_scalar(out[i][0], in[i], v);
+        break;
+    case LINMATH_BENCH_INVERT:
+        if (simd) for (int i = 0; i < count; i++) mat4x4_invert(out[i], in[i]);
+        else      for (int i = 0; i < count; i++) mat4x4_invert_scalar(out[i], in[i]);
+        break;
+    }
+}
+
+// Największa różnica względna między wynikami obu ścieżek (mat4x4_mul_vec4 zapisuje tylko kolumnę 0)
+static inline float linmathBenchDiff(int op, const mat4x4* a, const mat4x4* b, int count) {
+    int floats = op == LINMATH_BENCH_MUL_VEC4 ? 4 : 16;
+    float worst = 0.0f;
+    for (int i = 0; i < count; i++) {
+        const float* x = &a[i][0][0];
+        const float* y = &b[i][0][0];
+        for (int k = 0; k < floats; k++) {
+            float d = fabsf(x[k] - y[k]) / fmaxf(1.0f, fabsf(x[k]));
+            if (d > worst)
+                worst = d;
+        }
+    }
+    return worst;
+}
+
+// Zwraca 0, gdy zabrakło pamięci albo wyniki SIMD odbiegają od skalarnych bardziej niż błąd zaokrągleń
+static inline int linmathBenchmark(int count, int repeats) {
+    mat4x4* in = (mat4x4*)malloc(sizeof(mat4x4) * count);
+    mat4x4* scalarOut = (mat4x4*)malloc(sizeof(mat4x4) * count);
+    mat4x4* simdOut = (mat4x4*)malloc(sizeof(mat4x4) * count);
+    if (!in || !scalarOut || !simdOut) {
+        fprintf(stderr, "Brak pamięci na %d macierzy\n", count);
+        free(in);
+        free(scalarOut);
+        free(simdOut);
+        return 0;
+    }
+    // Powtarzalne wartości z przekątną dominującą, żeby każda macierz była odwracalna
+    for (int i = 0; i < count; i++)
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                in[i][c][r] = (float)((i * 7 + c * 13 + r * 5) % 17 - 8) * 0.1f + (c == r ? 3.0f : 0.0f);
+    mat4x4 PV;
+    mat4x4_perspective(PV, 1.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+    vec4 v = { 1.0f, 2.0f, 3.0f, 1.0f };
+
+    printf("linmath.h, %d macierzy, SIMD: %s, najlepszy z %d przebiegów (ns na macierz):\n", count, linmathSimdName(), repeats);
+    int ok = 1;
+    for (int op = 0; op < LINMATH_BENCH_OP_COUNT; op++) {
+        double best[2] = { 1e30, 1e30 };
+        for (int r = 0; r < repeats; r++) {
+            for (int simd = 0; simd < 2; simd++) {
+                auto start = std::chrono::steady_clock::now();
+                linmathBenchPass(op, simd, in, simd ? simdOut : scalarOut, count, PV, v);
+                double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                if (ns < best[simd])
+                    best[simd] = ns;
+            }
+        }
+        float diff = linmathBenchDiff(op, scalarOut, simdOut, count);
+        ok &= diff < 1e-4f;
+        printf("  %-16s skalarnie %6.2f  SIMD %6.2f  (x%.2f), różnica względna %g\n", linmathBenchOpNames[op],
+               best[0] / count, best[1] / count, best[0] / best[1], diff);
+    }
+    free(in);
+    free(scalarOut);
+    free(simdOut);
+    return ok;
+}
+
+#endif
@@ -4,12 +4,20 @@
 #include <GLFW/glfw3.h>
 
 #include "linmath.h"
+#include "frustum.h"
+#include "bvh.h"
+#include "transform.h"
+#include "linmathbench.h"
+#include "headless.h"
+#include "scene.h"
+#include "camerapath.h"
+#include "profiler.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
-#include <time.h>
+#include <string.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -67,6 +75,21 @@ static const char* vertex_shader_text =
 "    color = vCol;\n"
 "}\n";
 
+// Shader do rysowania instancyjnego - pozycja bryły przychodzi jako atrybut instancji
+// (glVertexAttribDivisor = 1), więc wszystkie bryły rysujemy jednym wywołaniem
+static const char* instanced_vertex_shader_text =
+"#version 110\n"
+"uniform mat4 VP;\n"
+"attribute vec3 vCol;\n"
+"attribute vec3 vPos;\n"
+"attribute vec3 vOffset;\n"
+"varying vec3 color;\n"
+"void main()\n"
+"{\n"
+"    gl_Position = VP * vec4(vPos + vOffset, 1.0);\n"
+"    color = vCol;\n"
+"}\n";
+
 static const char* fragment_shader_text =
 "#version 110\n"
 "varying vec3 color;\n"
@@ -75,6 +98,13 @@ static const char* fragment_shader_text =
 "    gl_FragColor = vec4(color, 1.0);\n"
 "}\n";
 
+// Tryby obcinania brył poza bryłą widzenia
+enum CullMode {
+    CULL_NONE,      // rysujemy wszystko
+    CULL_LINEAR,    // test każdej sfery (SIMD, paczkami po 4/8)
+    CULL_BVH        // hierarchiczny test na drzewie BVH
+};
+
 // Struktury do przechowywania stanu kamery i aplikacji
 typedef struct {
     vec3 position;
@@ -88,24 +118,64 @@ typedef struct {
     float moveSpeed;
     float mouseSensitivity;
     int keyW, keyS, keyA, keyD;  // które klawisze są wciśnięte
-    vec3 objectPositions[15];
+    vec3* objectPositions;       // tablica alokowana dynamicznie (numObjects elementów)
     int numObjects;
+    int instanced;               // 1 = jedna instancjonowana komenda rysowania dla wszystkich brył
+    int culling;                 // tryb obcinania (CullMode)
+    int pickRequested;           // klawisz P - wybranie bryły na środku ekranu
+    int traceRequested;          // klawisz T - zapis stref CPU do pliku Chrome trace
 } AppState;
 
 // Funkcje do obliczania macierzy widoku i kierunków kamery
+// Macierz kamery Wc = T * Ry(yaw) * Rx(pitch) jako przekształcenie sztywne (obrót + przesunięcie)
+void getCameraTransform(rigid* Wc, const Camera* camera) {
+    quat qy, qx;
+    vec3 yAxis = { 0.0f, 1.0f, 0.0f };
+    vec3 xAxis = { 1.0f, 0.0f, 0.0f };
+    quat_rotate(qy, camera->yaw, yAxis);
+    quat_rotate(qx, camera->pitch, xAxis);
+    quat_mul(Wc->q, qy, qx);
+    vec3_dup(Wc->t, camera->position);
+}
+
 void calculateViewMatrix(mat4x4 V, const Camera* camera) {
-    mat4x4 Wc, T, Ry, Rx;
-    
-    mat4x4_translate(T, camera->position[0], camera->position[1], camera->position[2]);
-    mat4x4_identity(Ry);
-    mat4x4_rotate_Y(Ry, Ry, camera->yaw);
-    mat4x4_identity(Rx);
-    mat4x4_rotate_X(Rx, Rx, camera->pitch);
-    
-    mat4x4_mul(Wc, Ry, Rx);
-    mat4x4_mul(Wc, T, Wc);
-    mat4x4_invert(V, Wc);  // macierz widoku to odwrotność macierzy kamery
+    rigid Wc, invWc;
+    getCameraTransform(&Wc, camera);
+    rigid_invert(&invWc, &Wc);  // macierz widoku to odwrotność macierzy kamery - bez ogólnego mat4x4_invert
+    mat4x4_from_rigid(V, &invWc);
+}
+
+#ifdef _DEBUG
+// Porównanie z dawną drogą przez mat4x4_invert dla siatki położeń i kątów kamery
+static void checkViewMatrix(void) {
+    float maxError = 0.0f;
+    for (int step = 0; step < 1000; step++) {
+        Camera camera;
+        camera.position[0] = (float)(step % 10) * 3.0f - 15.0f;
+        camera.position[1] = (float)(step / 10 % 10) * 3.0f - 15.0f;
+        camera.position[2] = (float)(step / 100) * 3.0f - 15.0f;
+        camera.yaw = (float)step * 0.37f;
+        camera.pitch = ((float)(step % 17) / 16.0f - 0.5f) * 3.0f;
+
+        mat4x4 Wc, T, Ry, Rx, expected, V;
+        mat4x4_translate(T, camera.position[0], camera.position[1], camera.position[2]);
+        mat4x4_identity(Ry);
+        mat4x4_rotate_Y(Ry, Ry, camera.yaw);
+        mat4x4_identity(Rx);
+        mat4x4_rotate_X(Rx, Rx, camera.pitch);
+        mat4x4_mul(Wc, Ry, Rx);
+        mat4x4_mul(Wc, T, Wc);
+        mat4x4_invert(expected, Wc);
+
+        calculateViewMatrix(V, &camera);
+        for (int c = 0; c < 4; c++)
+            for (int r = 0; r < 4; r++)
+                maxError = fmaxf(maxError, fabsf(V[c][r] - expected[c][r]));
+    }
+    if (maxError > 1e-4f)
+        fprintf(stderr, "calculateViewMatrix: odchylenie od mat4x4_invert %g\n", maxError);
 }
+#endif
 
 void getCameraForward(vec3 forward, const Camera* camera) {
     forward[0] = -sinf(camera->yaw) * cosf(camera->pitch);
@@ -158,6 +228,13 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
             if (app->fov < 10.0f) app->fov = 10.0f;
         }
     }
+    
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        app->pickRequested = 1;
+    }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        app->traceRequested = 1;
+    }
 }
 
 // Obsługa myszy - obraca kamerę gdy ruszasz myszką
@@ -194,7 +271,7 @@ static void cursor_position_callback(GLFWwindow* window, double xpos, double ypo
 }
 
 // Ustawienie początkowych wartości - kamera, prędkość, pozycje brył
-void initAppState(AppState* app) {
+void initAppState(AppState* app, int numObjects, int layout, uint64_t seed) {
     app->camera.position[0] = 0.0f;
     app->camera.position[1] = 0.0f;
     app->camera.position[2] = 8.0f;
@@ -206,33 +283,178 @@ void initAppState(AppState* app) {
     app->mouseSensitivity = 0.001f;
     
     app->keyW = app->keyS = app->keyA = app->keyD = 0;
-    // randomizuje pozycje brył
-    srand((unsigned int)time(NULL));
-    app->numObjects = 15;
-    for (int i = 0; i < app->numObjects; i++) {
-        app->objectPositions[i][0] = ((float)rand() / RAND_MAX) * 20.0f - 10.0f;
-        app->objectPositions[i][1] = ((float)rand() / RAND_MAX) * 10.0f - 5.0f;
-        app->objectPositions[i][2] = ((float)rand() / RAND_MAX) * 20.0f - 10.0f;
+    app->pickRequested = 0;
+    app->traceRequested = 0;
+    // pozycje brył z generatora sceny - to samo ziarno daje tę samą scenę
+    app->numObjects = numObjects;
+    app->objectPositions = (vec3*)malloc(sizeof(vec3) * numObjects);
+    if (!app->objectPositions) {
+        fprintf(stderr, "Brak pamięci na %d brył\n", numObjects);
+        exit(EXIT_FAILURE);
     }
+    generateScene(app->objectPositions, numObjects, layout, seed);
+}
+
+// Przeniesienie stanu kamery do/z klatki nagrania (ta scena nie ma światła)
+static void capturePathFrame(const AppState* app, CameraPathFrame* frame) {
+    memset(frame, 0, sizeof(*frame));
+    memcpy(frame->position, app->camera.position, sizeof(frame->position));
+    frame->yaw = app->camera.yaw;
+    frame->pitch = app->camera.pitch;
+    frame->fov = app->fov;
+}
+
+static void applyPathFrame(AppState* app, const CameraPathFrame* frame) {
+    memcpy(app->camera.position, frame->position, sizeof(frame->position));
+    app->camera.yaw = frame->yaw;
+    app->camera.pitch = frame->pitch;
+    app->fov = frame->fov;
 }
 
 // Główna funkcja - inicjalizuje okno, shadery i uruchamia pętlę renderowania
-int main(void)
+// Argumenty: --instanced (rysowanie instancyjne), --count N (liczba brył, domyślnie 15),
+//            --no-cull (bez obcinania brył poza kamerą), --linear-cull (obcinanie bez BVH),
+//            --seed S (domyślnie 1) i --layout uniform|clustered|grid|corridor (powtarzalna scena),
+//            --headless [--frames N] (pomiar bez okna),
+//            --record plik / --replay plik (nagranie i odtworzenie ścieżki kamery),
+//            --trace plik (strefy CPU w formacie Chrome trace przy wyjściu i pod klawiszem T),
+//            --linmath-bench (pomiar linmath.h: pętle skalarne kontra SIMD, bez okna)
+int main(int argc, char** argv)
 {
     GLFWwindow* window;
-    GLuint vertex_buffer, vertex_shader, fragment_shader, program;
-    GLint mvp_location, vpos_location, vcol_location;
+    GLuint vertex_buffer, instance_buffer = 0, vertex_shader, fragment_shader, program;
+    GLint mvp_location, vpos_location, vcol_location, voffset_location = -1;
+    
+    int numObjects = 15;
+    int instanced = 0;
+    int culling = CULL_BVH;
+    int layout = LAYOUT_UNIFORM;
+    uint64_t seed = 1;  // stałe, żeby pomiar bez --seed też był powtarzalny
+    const char* traceFile = NULL;
+    int linmathBench = 0;
+    Headless headless;
+    headlessInit(&headless);
+    CameraPath path;
+    cameraPathInit(&path);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--instanced") == 0) {
+            instanced = 1;
+        } else if (strcmp(argv[i], "--no-cull") == 0) {
+            culling = CULL_NONE;
+        } else if (strcmp(argv[i], "--linear-cull") == 0) {
+            culling = CULL_LINEAR;
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            numObjects = atoi(argv[++i]);
+            if (numObjects < 1) numObjects = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc && sceneLayoutFromName(argv[i + 1]) >= 0) {
+            layout = sceneLayoutFromName(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            cameraPathStartRecording(&path, argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!cameraPathLoad(&path, argv[++i]))
+                exit(EXIT_FAILURE);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless.enabled = 1;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headless.frames = atoi(argv[++i]);
+            if (headless.frames < 1) headless.frames = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--linmath-bench") == 0) {
+            linmathBench = 1;
+        } else {
+            fprintf(stderr, "Nieznany argument: %s\n", argv[i]);
+            fprintf(stderr, "Użycie: %s [--instanced] [--count N] [--no-cull | --linear-cull] [--seed S]\n"
+                            "       [--layout uniform|clustered|grid|corridor] [--headless [--frames N]]\n"
+                            "       [--record plik | --replay plik] [--trace plik] [--linmath-bench]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
     
+#ifdef _DEBUG
+    checkViewMatrix();
+#endif
+    // Sam pomiar linmath.h na milionie macierzy - bez sceny i okna
+    if (linmathBench)
+        exit(linmathBenchmark(1000000, 5) ? EXIT_SUCCESS : EXIT_FAILURE);
+
     AppState app;
-    initAppState(&app);
+    initAppState(&app, numObjects, layout, seed);
+    printf("Scena: %d brył, układ %s, ziarno %llu\n", numObjects, sceneLayoutNames[layout], (unsigned long long)seed);
+    app.culling = culling;
+
+    // Sfera otaczająca bryłę (w układzie modelu) i sfery wszystkich brył w świecie do obcinania
+    vec3 prismCenter;
+    float prismRadius;
+    computeBoundingSphere(prismCenter, &prismRadius, vertices, sizeof(vertices) / sizeof(vertices[0]), sizeof(vertices[0]));
+
+    CullSet cullSet;
+    cullSetInit(&cullSet);
+    int* visibleIndices = (int*)malloc(sizeof(int) * app.numObjects);
+    vec3* visiblePositions = (vec3*)malloc(sizeof(vec3) * app.numObjects);
+    if (!cullSetResize(&cullSet, app.numObjects) || !visibleIndices || !visiblePositions) {
+        fprintf(stderr, "Brak pamięci na dane obcinania\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < app.numObjects; i++) {
+        vec3 center;
+        vec3_add(center, prismCenter, app.objectPositions[i]);
+        cullSetSphere(&cullSet, i, center, prismRadius);
+    }
+
+    // Położenia brył dla wsadowego liczenia macierzy MVP (bez obrotu, skala 1)
+    TransformSet transforms;
+    transformSetInit(&transforms);
+    mat4x4* mvpMatrices = (mat4x4*)malloc(sizeof(mat4x4) * app.numObjects);
+    if (!mvpMatrices || !transformSetResize(&transforms, app.numObjects)) {
+        fprintf(stderr, "Brak pamięci na macierze brył\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < app.numObjects; i++) {
+        quat noRotation;
+        vec3 unitScale = { 1.0f, 1.0f, 1.0f };
+        quat_identity(noRotation);
+        transformSetObject(&transforms, i, app.objectPositions[i], noRotation, unitScale);
+    }
+    // Stałe wątki robocze do macierzy - tworzone raz, nie w każdej klatce
+    ThreadPool workers;
+    threadPoolInit(&workers, -1);
 
     glfwSetErrorCallback(error_callback);
 
+    headlessPrepareGlfw(&headless);
     if (!glfwInit())
         exit(EXIT_FAILURE);
 
+    // Drzewo BVH nad prostopadłościanami brył - do obcinania i wybierania bryły klawiszem P
+    vec3 prismMin, prismMax;
+    computeBoundingBox(prismMin, prismMax, vertices, sizeof(vertices) / sizeof(vertices[0]), sizeof(vertices[0]));
+    vec3* boxMin = (vec3*)malloc(sizeof(vec3) * app.numObjects);
+    vec3* boxMax = (vec3*)malloc(sizeof(vec3) * app.numObjects);
+    Bvh bvh;
+    bvhInit(&bvh);
+    if (!boxMin || !boxMax) {
+        fprintf(stderr, "Brak pamięci na dane BVH\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < app.numObjects; i++) {
+        vec3_add(boxMin[i], prismMin, app.objectPositions[i]);
+        vec3_add(boxMax[i], prismMax, app.objectPositions[i]);
+    }
+    double buildStart = glfwGetTime();
+    if (!bvhBuild(&bvh, boxMin, boxMax, app.numObjects)) {
+        fprintf(stderr, "Brak pamięci na drzewo BVH\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("BVH: %d węzłów, budowa %.3f ms\n", bvh.numNodes, (glfwGetTime() - buildStart) * 1000.0);
+    free(boxMin);
+    free(boxMax);
+
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    headlessWindowHints(&headless);
 
     window = glfwCreateWindow(1024, 768, "Kamera pierwszoosobowa (FPS)", NULL, NULL);
     if (!window)
@@ -248,7 +470,16 @@ int main(void)
 
     glfwMakeContextCurrent(window);
     gladLoadGL(); // inicjalizacja OpenGL
-    glfwSwapInterval(1);
+    glfwSwapInterval(headless.enabled ? 0 : 1); // w trybie bez okna bez vsync - mierzymy pełną przepustowość
+    headlessCreateTarget(&headless);
+
+    // glVertexAttribDivisor i glDrawArraysInstanced są dostępne od OpenGL 3.3
+    if (instanced && !GLAD_GL_VERSION_3_3) {
+        fprintf(stderr, "OpenGL 3.3 niedostępny - rysowanie instancyjne wyłączone\n");
+        instanced = 0;
+    }
+    app.instanced = instanced;
+    printf("Bryły: %d, tryb: %s\n", app.numObjects, app.instanced ? "instancyjny" : "pojedyncze wywołania");
 
     glEnable(GL_DEPTH_TEST); // włączenie testu głębi - obiekty bliżej zasłaniają dalsze 
     glDepthFunc(GL_LESS);
@@ -261,7 +492,7 @@ int main(void)
 
     // tworzenie shaderów
     vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vertex_shader_text, NULL);
+    glShaderSource(vertex_shader, 1, app.instanced ? &instanced_vertex_shader_text : &vertex_shader_text, NULL);
     glCompileShader(vertex_shader);
 
     fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -274,7 +505,8 @@ int main(void)
     glAttachShader(program, fragment_shader);
     glLinkProgram(program);
 
-    mvp_location = glGetUniformLocation(program, "MVP");
+    // w trybie instancyjnym shader dostaje samo VP, a przesunięcie bryły z atrybutu vOffset
+    mvp_location = glGetUniformLocation(program, app.instanced ? "VP" : "MVP");
     vpos_location = glGetAttribLocation(program, "vPos");
     vcol_location = glGetAttribLocation(program, "vCol");
 
@@ -285,48 +517,90 @@ int main(void)
     glVertexAttribPointer(vcol_location, 3, GL_FLOAT, GL_FALSE,
         sizeof(vertices[0]), (void*)(sizeof(float) * 3));
 
+    // bufor z pozycjami brył - jeden wpis na instancję
+    if (app.instanced) {
+        voffset_location = glGetAttribLocation(program, "vOffset");
+        glGenBuffers(1, &instance_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+        // przy obcinaniu bufor jest wypełniany co klatkę tylko widocznymi bryłami
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vec3) * app.numObjects, app.objectPositions,
+                     app.culling != CULL_NONE ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+        glEnableVertexAttribArray(voffset_location);
+        glVertexAttribPointer(voffset_location, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+        glVertexAttribDivisor(voffset_location, 1); // atrybut zmienia się co instancję, nie co wierzchołek
+    }
+
     // Główna pętla renderowania - rysuje obraz 60 razy na sekundę
     double lastTime = glfwGetTime();
+    double statsTime = lastTime;
+    int frameCount = 0;
+    double cullTimeSum = 0.0;
     
+    profilerInit();
     while (!glfwWindowShouldClose(window))
     {
+        profilerBegin("klatka");
         // obliczanie czasu między klatkami do płynnego ruchu
         double currentTime = glfwGetTime();
         float deltaTime = (float)(currentTime - lastTime);
         lastTime = currentTime;
         
+        // Odtwarzanie nagranej ścieżki - kamera z pliku, stały krok czasu zamiast zegara
+        if (path.mode == PATH_REPLAY) {
+            CameraPathFrame pathFrame;
+            if (!cameraPathNext(&path, &pathFrame)) {
+                profilerEnd();
+                break;
+            }
+            applyPathFrame(&app, &pathFrame);
+            deltaTime = path.timestep;
+        }
+        
+        headlessBeginFrame(&headless);
+
         int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        headlessFramebufferSize(&headless, window, &width, &height);
         float ratio = width / (float)height;
 
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // czyszczenie ekranu
 
-        // Poruszanie kamerą na podstawie wciśniętych klawiszy
+        // Poruszanie kamerą na podstawie wciśniętych klawiszy (przy odtwarzaniu klawisze są ignorowane)
+        profilerBegin("wejscie");
         vec3 forward, right;
         getCameraForward(forward, &app.camera);
         getCameraRight(right, &app.camera);
         
-        if (app.keyW) {
-            app.camera.position[0] += forward[0] * app.moveSpeed * deltaTime;
-            app.camera.position[1] += forward[1] * app.moveSpeed * deltaTime;
-            app.camera.position[2] += forward[2] * app.moveSpeed * deltaTime;
+        if (path.mode != PATH_REPLAY) {
+            if (app.keyW) {
+                app.camera.position[0] += forward[0] * app.moveSpeed * deltaTime;
+                app.camera.position[1] += forward[1] * app.moveSpeed * deltaTime;
+                app.camera.position[2] += forward[2] * app.moveSpeed * deltaTime;
+            }
+            if (app.keyS) {
+                app.camera.position[0] -= forward[0] * app.moveSpeed * deltaTime;
+                app.camera.position[1] -= forward[1] * app.moveSpeed * deltaTime;
+                app.camera.position[2] -= forward[2] * app.moveSpeed * deltaTime;
+            }
+            if (app.keyA) {
+                app.camera.position[0] -= right[0] * app.moveSpeed * deltaTime;
+                app.camera.position[2] -= right[2] * app.moveSpeed * deltaTime;
+            }
+            if (app.keyD) {
+                app.camera.position[0] += right[0] * app.moveSpeed * deltaTime;
+                app.camera.position[2] += right[2] * app.moveSpeed * deltaTime;
+            }
         }
-        if (app.keyS) {
-            app.camera.position[0] -= forward[0] * app.moveSpeed * deltaTime;
-            app.camera.position[1] -= forward[1] * app.moveSpeed * deltaTime;
-            app.camera.position[2] -= forward[2] * app.moveSpeed * deltaTime;
-        }
-        if (app.keyA) {
-            app.camera.position[0] -= right[0] * app.moveSpeed * deltaTime;
-            app.camera.position[2] -= right[2] * app.moveSpeed * deltaTime;
-        }
-        if (app.keyD) {
-            app.camera.position[0] += right[0] * app.moveSpeed * deltaTime;
-            app.camera.position[2] += right[2] * app.moveSpeed * deltaTime;
+        
+        if (path.mode == PATH_RECORD) {
+            CameraPathFrame pathFrame;
+            capturePathFrame(&app, &pathFrame);
+            cameraPathRecord(&path, &pathFrame);
         }
+        profilerEnd();
 
         // Obliczanie macierzy rzutowania (perspektywa) - przekształca 3D na 2D ekran
+        profilerBegin("kamera");
         mat4x4 P;
         float fov_rad = app.fov * (float)M_PI / 180.0f;
         float near = 0.1f;
@@ -337,36 +611,127 @@ int main(void)
         mat4x4 V;
         calculateViewMatrix(V, &app.camera);
 
+        // Obcinanie - zostają tylko bryły przecinające bryłę widzenia
+        mat4x4 PV;
+        mat4x4_mul(PV, P, V);
+        profilerEnd();
+        profilerBegin("obcinanie");
+        int visibleCount = app.numObjects;
+        if (app.culling != CULL_NONE) {
+            Frustum frustum;
+            frustumFromMatrix(&frustum, PV);
+            double cullStart = glfwGetTime();
+            if (app.culling == CULL_BVH)
+                visibleCount = bvhCullFrustum(&bvh, &frustum, visibleIndices);
+            else
+                visibleCount = frustumCullSpheres(&frustum, &cullSet, visibleIndices);
+            cullTimeSum += glfwGetTime() - cullStart;
+        } else {
+            for (int i = 0; i < app.numObjects; i++)
+                visibleIndices[i] = i;
+        }
+        profilerEnd();
+
         // Rysowanie wszystkich brył - dla każdej obliczamy jak wygląda z perspektywy kamery
         glUseProgram(program);
         
-        for (int i = 0; i < app.numObjects; i++) {
-            mat4x4 M, MVP;
-            
-            // przesunięcie bryły do jej pozycji w świecie 3D
-            mat4x4_identity(M);
-            mat4x4_translate_in_place(M, app.objectPositions[i][0],
-                                          app.objectPositions[i][1],
-                                          app.objectPositions[i][2]);
-            
+        if (app.instanced) {
+            // wszystkie bryły jednym wywołaniem - przy obcinaniu wysyłamy tylko pozycje widocznych
+            profilerBegin("uniformy");
+            if (app.culling != CULL_NONE) {
+                for (int i = 0; i < visibleCount; i++)
+                    vec3_dup(visiblePositions[i], app.objectPositions[visibleIndices[i]]);
+                glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(vec3) * visibleCount, visiblePositions, GL_STREAM_DRAW);
+            }
+            glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*)PV);
+            profilerEnd();
+            profilerBegin("rysowanie");
+            if (visibleCount > 0)
+                glDrawArraysInstanced(GL_TRIANGLES, 0, sizeof(vertices) / sizeof(vertices[0]), visibleCount);
+            profilerEnd();
+        } else {
             // MVP = macierz która przekształca wierzchołki 3D na pozycje na ekranie 2D
-            // (Model * View * Projection)
-            mat4x4_mul(MVP, V, M);
-            mat4x4_mul(MVP, P, MVP);
-            
-            glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*)MVP);
-            glDrawArrays(GL_TRIANGLES, 0, sizeof(vertices) / sizeof(vertices[0])); // rysowanie bryły
+            // (Projection * View * Model) - liczona od razu dla wszystkich widocznych brył
+            profilerBegin("macierze");
+            transformCompute(&transforms, visibleIndices, visibleCount, PV, mvpMatrices, NULL, &workers);
+            profilerEnd();
+            // Uniform MVP przeplata się z rysowaniem, więc oba są w jednej strefie
+            profilerBegin("uniformy i rysowanie");
+            for (int v = 0; v < visibleCount; v++) {
+                glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*)mvpMatrices[v]);
+                glDrawArrays(GL_TRIANGLES, 0, sizeof(vertices) / sizeof(vertices[0])); // rysowanie bryły
+            }
+            profilerEnd();
+        }
+
+        // Wybieranie bryły - promień z kamery wzdłuż kierunku patrzenia
+        if (app.pickRequested) {
+            app.pickRequested = 0;
+            float hitT = 0.0f;
+            double pickStart = glfwGetTime();
+            int hit = bvhRaycast(&bvh, app.camera.position, forward, far, &hitT);
+            double pickMs = (glfwGetTime() - pickStart) * 1000.0;
+            if (hit >= 0)
+                printf("Wybrano bryłę %d (odległość %.2f, zapytanie %.4f ms)\n", hit, hitT, pickMs);
+            else
+                printf("Nic nie trafiono (zapytanie %.4f ms)\n", pickMs);
+        }
+
+        // raz na sekundę pokazujemy w tytule okna liczbę widocznych i odrzuconych brył
+        frameCount++;
+        if (currentTime - statsTime >= 1.0) {
+            char title[256];
+            snprintf(title, sizeof(title), "Kamera pierwszoosobowa (FPS) | %.0f FPS | widoczne: %d, odrzucone: %d | obcinanie: %.3f ms",
+                     frameCount / (currentTime - statsTime), visibleCount, app.numObjects - visibleCount,
+                     cullTimeSum * 1000.0 / frameCount);
+            glfwSetWindowTitle(window, title);
+            frameCount = 0;
+            cullTimeSum = 0.0;
+            statsTime = currentTime;
         }
 
+        profilerBegin("glfwSwapBuffers");
         glfwSwapBuffers(window); // wyświetlenie narysowanej klatki
+        profilerEnd();
+        profilerBegin("glfwPollEvents");
         glfwPollEvents(); // sprawdzenie zdarzeń (klawisze, mysz)
+        profilerEnd();
+        headlessEndFrame(&headless, window);
+        if (path.mode == PATH_REPLAY)
+            cameraPathFrameDone(&path, glfwGetTime());
+        profilerEnd();
+        
+        // Zapis stref na żądanie - np. zaraz po zauważonym przycięciu
+        if (app.traceRequested) {
+            app.traceRequested = 0;
+            profilerWriteTrace(traceFile ? traceFile : "trace.json");
+        }
     }
+    if (traceFile)
+        profilerWriteTrace(traceFile);
+    headlessReport(&headless);
+    if (path.mode == PATH_RECORD)
+        cameraPathSave(&path);
+    cameraPathReport(&path);
+    cameraPathFree(&path);
 
     glDeleteBuffers(1, &vertex_buffer);
+    if (instance_buffer)
+        glDeleteBuffers(1, &instance_buffer);
     glDeleteProgram(program);
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
+    free(app.objectPositions);
+    free(visibleIndices);
+    free(visiblePositions);
+    cullSetFree(&cullSet);
+    bvhFree(&bvh);
+    transformSetFree(&transforms);
+    free(mvpMatrices);
+    threadPoolFree(&workers);
+
     glfwDestroyWindow(window);
     glfwTerminate();
     exit(EXIT_SUCCESS);
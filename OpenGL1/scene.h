@@ -0,0 +1,152 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+// Powtarzalny generator sceny testowej. Dla tego samego ziarna, liczby brył i układu
+// zawsze powstają te same pozycje - niezależnie od implementacji rand(). Gwarancja dotyczy tego
+// samego programu (kompilator i biblioteka C): cbrtf, logf i cosf nie dają identycznych bitów
+// w MSVC i glibc, więc między platformami pozycje mogą się różnić na ostatnich bitach.
+// Generator liczb losowych: PCG32 (O'Neill), szybki i z dobrym rozkładem.
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "linmath.h"
+
+// Korytarz mieści się w bryle widzenia kamery startowej z main.cpp (z = 8, fov 60°, 4:3, far = 100):
+// nie dłuższy niż 80 jednostek, a przekrój na głębokości d od kamery najwyżej d * tan połowy kąta
+// (z zapasem na rozmiar bryły)
+#define SCENE_CAMERA_Z 8.0f
+#define SCENE_CORRIDOR_MAX_LENGTH 80.0f
+#define SCENE_CORRIDOR_TAN_X 0.7f
+#define SCENE_CORRIDOR_TAN_Y 0.5f
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} Pcg32;
+
+static inline uint32_t pcg32Next(Pcg32* rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+}
+
+static inline void pcg32Seed(Pcg32* rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0u;
+    rng->inc = (stream << 1u) | 1u;
+    pcg32Next(rng);
+    rng->state += seed;
+    pcg32Next(rng);
+}
+
+// Liczba z przedziału [0, 1) - 24 bity, tyle ile mieści mantysa floata
+static inline float pcg32Float(Pcg32* rng) {
+    return (float)(pcg32Next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float pcg32Range(Pcg32* rng, float lo, float hi) {
+    return lo + (hi - lo) * pcg32Float(rng);
+}
+
+// Rozkład normalny (metoda Boxa-Mullera, drugą wartość pomijamy)
+static inline float pcg32Normal(Pcg32* rng) {
+    float u1 = 1.0f - pcg32Float(rng); // (0, 1] - bez logf(0)
+    float u2 = pcg32Float(rng);
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * 3.14159265f * u2);
+}
+
+enum SceneLayout {
+    LAYOUT_UNIFORM,     // równomiernie w prostopadłościanie (jak dawne rand())
+    LAYOUT_CLUSTERED,   // skupiska wokół losowych środków
+    LAYOUT_GRID,        // regularna siatka 3D
+    LAYOUT_CORRIDOR,    // gęsty korytarz wzdłuż osi -Z, na wprost kamery
+    LAYOUT_COUNT
+};
+
+static const char* const sceneLayoutNames[LAYOUT_COUNT] = { "uniform", "clustered", "grid", "corridor" };
+
+// Zwraca -1 dla nieznanej nazwy
+static inline int sceneLayoutFromName(const char* name) {
+    for (int i = 0; i < LAYOUT_COUNT; i++) {
+        if (strcmp(name, sceneLayoutNames[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// Pozycje count brył. Obszar rośnie z liczbą brył tak, żeby gęstość była taka jak
+// dla domyślnych 15 brył w prostopadłościanie 20 x 10 x 20.
+static inline void generateScene(vec3* positions, int count, int layout, uint64_t seed) {
+    Pcg32 rng;
+    pcg32Seed(&rng, seed, (uint64_t)layout);
+    float scale = count > 15 ? cbrtf((float)count / 15.0f) : 1.0f;
+    float hx = 10.0f * scale, hy = 5.0f * scale, hz = 10.0f * scale;
+
+    switch (layout) {
+    case LAYOUT_CLUSTERED: {
+        int numClusters = 1 + count / 256;
+        float sigma = 1.5f * cbrtf((float)count / numClusters / 15.0f + 1.0f);
+        vec3 center = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < count; i++) {
+            // Bryły przydzielane kolejno do skupisk - nowy środek co count/numClusters brył
+            if (i % ((count + numClusters - 1) / numClusters) == 0) {
+                center[0] = pcg32Range(&rng, -hx, hx);
+                center[1] = pcg32Range(&rng, -hy, hy);
+                center[2] = pcg32Range(&rng, -hz, hz);
+            }
+            positions[i][0] = center[0] + sigma * pcg32Normal(&rng);
+            positions[i][1] = center[1] + sigma * pcg32Normal(&rng);
+            positions[i][2] = center[2] + sigma * pcg32Normal(&rng);
+        }
+        break;
+    }
+    case LAYOUT_GRID: {
+        // Odstęp 2 jednostki (bryła ma ok. 1 jednostkę), siatka możliwie sześcienna,
+        // wyśrodkowana w X i Y, a w Z zaczyna się tuż przed kamerą startową i biegnie w głąb
+        int n = (int)ceilf(cbrtf((float)count));
+        float offset = (n - 1) * 0.5f * 2.0f;
+        for (int i = 0; i < count; i++) {
+            positions[i][0] = (float)(i % n) * 2.0f - offset;
+            positions[i][1] = (float)(i / n % n) * 2.0f - offset;
+            positions[i][2] = -(float)(i / (n * n)) * 2.0f;
+        }
+        break;
+    }
+    case LAYOUT_CORRIDOR: {
+        // Wszystko w polu widzenia kamery startowej: najgorszy przypadek dla obcinania.
+        // Korytarz 4 x 3 wydłuża się z liczbą brył do SCENE_CORRIDOR_MAX_LENGTH (przed płaszczyzną far),
+        // dalej przy tej samej gęstości rośnie przekrój - na każdej głębokości przycinany do bryły widzenia.
+        float length = 4.0f + count * 0.05f;
+        float widen = 1.0f;
+        if (length > SCENE_CORRIDOR_MAX_LENGTH) {
+            widen = sqrtf(length / SCENE_CORRIDOR_MAX_LENGTH);
+            length = SCENE_CORRIDOR_MAX_LENGTH;
+        }
+        for (int i = 0; i < count; i++) {
+            float fx = pcg32Float(&rng);
+            float fy = pcg32Float(&rng);
+            float z = pcg32Range(&rng, -length, 0.0f);
+            float distance = SCENE_CAMERA_Z - z;
+            float hx = 2.0f * widen, hy = 1.5f * widen;
+            if (hx > SCENE_CORRIDOR_TAN_X * distance) hx = SCENE_CORRIDOR_TAN_X * distance;
+            if (hy > SCENE_CORRIDOR_TAN_Y * distance) hy = SCENE_CORRIDOR_TAN_Y * distance;
+            positions[i][0] = -hx + 2.0f * hx * fx;
+            positions[i][1] = -hy + 2.0f * hy * fy;
+            positions[i][2] = z;
+        }
+        break;
+    }
+    default:
+        for (int i = 0; i < count; i++) {
+            positions[i][0] = pcg32Range(&rng, -hx, hx);
+            positions[i][1] = pcg32Range(&rng, -hy, hy);
+            positions[i][2] = pcg32Range(&rng, -hz, hz);
+        }
+        break;
+    }
+}
+
+#endif
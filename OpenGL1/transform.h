@@ -0,0 +1,200 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+// Wsadowe liczenie macierzy modelu M = T * R * S oraz MVP = PV * M dla wielu obiektów naraz.
+// Pozycje, obroty (kwaterniony) i skale trzymane są jako struktura tablic, więc jedna paczka
+// SSE liczy ten sam element macierzy dla 4 obiektów, a transpozycja 4x4 zapisuje wynik
+// jako zwykłą tablicę mat4x4 - gotową do glUniformMatrix4fv albo do bufora instancji.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "linmath.h"
+#include "threadpool.h"
+
+// Poniżej tylu obiektów na wątek dzielenie pracy się nie opłaca (wielokrotność 4)
+#define TRANSFORM_MIN_PER_THREAD 4096
+
+typedef struct {
+    float* px; float* py; float* pz;            // pozycja
+    float* qx; float* qy; float* qz; float* qw; // obrót
+    float* sx; float* sy; float* sz;            // skala
+    int count;
+    int capacity;
+} TransformSet;
+
+static inline void transformSetInit(TransformSet* set) {
+    memset(set, 0, sizeof(*set));
+}
+
+static inline void transformSetFree(TransformSet* set) {
+    float** arrays[10] = { &set->px, &set->py, &set->pz, &set->qx, &set->qy,
+                           &set->qz, &set->qw, &set->sx, &set->sy, &set->sz };
+    for (int a = 0; a < 10; a++)
+        free(*arrays[a]);
+    memset(set, 0, sizeof(*set));
+}
+
+// Zmiana liczby obiektów; zwraca 0 gdy zabrakło pamięci
+static inline int transformSetResize(TransformSet* set, int count) {
+    if (count > set->capacity) {
+        float** arrays[10] = { &set->px, &set->py, &set->pz, &set->qx, &set->qy,
+                               &set->qz, &set->qw, &set->sx, &set->sy, &set->sz };
+        int ok = 1;
+        for (int a = 0; a < 10; a++) {
+            float* p = (float*)realloc(*arrays[a], sizeof(float) * count);
+            if (p) *arrays[a] = p;
+            else ok = 0;
+        }
+        if (!ok)
+            return 0;
+        set->capacity = count;
+    }
+    set->count = count;
+    return 1;
+}
+
+static inline void transformSetPosition(TransformSet* set, int i, vec3 const position) {
+    set->px[i] = position[0];
+    set->py[i] = position[1];
+    set->pz[i] = position[2];
+}
+
+static inline void transformSetObject(TransformSet* set, int i, vec3 const position, quat const rotation, vec3 const scale) {
+    transformSetPosition(set, i, position);
+    set->qx[i] = rotation[0];
+    set->qy[i] = rotation[1];
+    set->qz[i] = rotation[2];
+    set->qw[i] = rotation[3];
+    set->sx[i] = scale[0];
+    set->sy[i] = scale[1];
+    set->sz[i] = scale[2];
+}
+
+// Jeden obiekt bez SIMD - reszta paczki albo całość na platformach bez SSE
+static inline void transformComputeOne(const TransformSet* set, int i, mat4x4 const PV, mat4x4 MVP, mat4x4 M) {
+    mat4x4 model;
+    quat q = { set->qx[i], set->qy[i], set->qz[i], set->qw[i] };
+    mat4x4_from_quat(model, q);
+    vec4_scale(model[0], model[0], set->sx[i]);
+    vec4_scale(model[1], model[1], set->sy[i]);
+    vec4_scale(model[2], model[2], set->sz[i]);
+    model[3][0] = set->px[i];
+    model[3][1] = set->py[i];
+    model[3][2] = set->pz[i];
+    if (MVP)
+        mat4x4_mul(MVP, PV, model);
+    if (M)
+        mat4x4_dup(M, model);
+}
+
+#ifdef LINMATH_SIMD_SSE
+// 4 kolejne obiekty lub 4 obiekty wskazane indeksami
+static inline __m128 transformLoad4(const float* a, const int* indices, int first) {
+    if (indices)
+        return _mm_setr_ps(a[indices[first]], a[indices[first + 1]], a[indices[first + 2]], a[indices[first + 3]]);
+    return _mm_loadu_ps(a + first);
+}
+
+// Kolumna c macierzy (rzędy w rejestrach, po jednym obiekcie na element) -> 4 obiekty
+static inline void transformStoreColumn4(mat4x4* out, int first, int c, __m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(out[first][c], r0);
+    _mm_storeu_ps(out[first + 1][c], r1);
+    _mm_storeu_ps(out[first + 2][c], r2);
+    _mm_storeu_ps(out[first + 3][c], r3);
+}
+#endif
+
+// Macierze dla obiektów first..last-1 partii. indices (może być NULL) wybiera obiekty zbioru,
+// wyniki trafiają pod kolejne pozycje partii: mvpOut[k] dla obiektu indices[k].
+// mOut może być NULL gdy macierz modelu nie jest potrzebna.
+static inline void transformComputeRange(const TransformSet* set, const int* indices, int first, int last,
+                                         mat4x4 const PV, mat4x4* mvpOut, mat4x4* mOut) {
+    int k = first;
+#ifdef LINMATH_SIMD_SSE
+    __m128 pv[4][4];
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            pv[c][r] = _mm_set1_ps(PV[c][r]);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    for (; k + 4 <= last; k += 4) {
+        __m128 b = transformLoad4(set->qx, indices, k);
+        __m128 c = transformLoad4(set->qy, indices, k);
+        __m128 d = transformLoad4(set->qz, indices, k);
+        __m128 a = transformLoad4(set->qw, indices, k);
+        __m128 sx = transformLoad4(set->sx, indices, k);
+        __m128 sy = transformLoad4(set->sy, indices, k);
+        __m128 sz = transformLoad4(set->sz, indices, k);
+
+        // Obrót jak w mat4x4_from_quat, od razu przemnożony przez skalę
+        __m128 a2 = _mm_mul_ps(a, a), b2 = _mm_mul_ps(b, b), c2 = _mm_mul_ps(c, c), d2 = _mm_mul_ps(d, d);
+        __m128 bc = _mm_mul_ps(b, c), ad = _mm_mul_ps(a, d), bd = _mm_mul_ps(b, d);
+        __m128 ac = _mm_mul_ps(a, c), cd = _mm_mul_ps(c, d), ab = _mm_mul_ps(a, b);
+        __m128 m[4][3];
+        m[0][0] = _mm_mul_ps(sx, _mm_sub_ps(_mm_add_ps(a2, b2), _mm_add_ps(c2, d2)));
+        m[0][1] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(bc, ad)));
+        m[0][2] = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(bd, ac)));
+        m[1][0] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(bc, ad)));
+        m[1][1] = _mm_mul_ps(sy, _mm_add_ps(_mm_sub_ps(a2, b2), _mm_sub_ps(c2, d2)));
+        m[1][2] = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(cd, ab)));
+        m[2][0] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(bd, ac)));
+        m[2][1] = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(cd, ab)));
+        m[2][2] = _mm_mul_ps(sz, _mm_sub_ps(_mm_sub_ps(a2, b2), _mm_sub_ps(c2, d2)));
+        m[3][0] = transformLoad4(set->px, indices, k);
+        m[3][1] = transformLoad4(set->py, indices, k);
+        m[3][2] = transformLoad4(set->pz, indices, k);
+
+        if (mOut) {
+            for (int col = 0; col < 4; col++)
+                transformStoreColumn4(mOut, k, col, m[col][0], m[col][1], m[col][2], col == 3 ? one : zero);
+        }
+        if (mvpOut) {
+            // MVP[col][r] = sum PV[j][r] * M[col][j]; czwarty wiersz M to (0, 0, 0, 1)
+            for (int col = 0; col < 4; col++) {
+                __m128 r4[4];
+                for (int r = 0; r < 4; r++) {
+                    __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pv[0][r], m[col][0]), _mm_mul_ps(pv[1][r], m[col][1])),
+                                          _mm_mul_ps(pv[2][r], m[col][2]));
+                    r4[r] = col == 3 ? _mm_add_ps(t, pv[3][r]) : t;
+                }
+                transformStoreColumn4(mvpOut, k, col, r4[0], r4[1], r4[2], r4[3]);
+            }
+        }
+    }
+#endif
+    for (; k < last; k++)
+        transformComputeOne(set, indices ? indices[k] : k, PV, mvpOut ? mvpOut[k] : NULL, mOut ? mOut[k] : NULL);
+}
+
+typedef struct {
+    const TransformSet* set;
+    const int* indices;
+    const vec4* PV;
+    mat4x4* mvpOut;
+    mat4x4* mOut;
+} TransformJob;
+
+static inline void transformComputeChunk(void* arg, int begin, int end) {
+    const TransformJob* job = (const TransformJob*)arg;
+    transformComputeRange(job->set, job->indices, begin, end, job->PV, job->mvpOut, job->mOut);
+}
+
+// Macierze dla count obiektów (wszystkich z indices == NULL albo wskazanych indeksami).
+// Przy dużej liczbie obiektów kawałki po TRANSFORM_MIN_PER_THREAD liczą stałe wątki pool (wątek
+// wywołujący też pracuje) - bez tworzenia wątków w każdej klatce. pool == NULL - jeden wątek.
+static inline void transformCompute(const TransformSet* set, const int* indices, int count,
+                                    mat4x4 const PV, mat4x4* mvpOut, mat4x4* mOut, ThreadPool* pool) {
+    if (!pool || pool->numWorkers == 0 || count < 2 * TRANSFORM_MIN_PER_THREAD) {
+        transformComputeRange(set, indices, 0, count, PV, mvpOut, mOut);
+        return;
+    }
+    // Kawałek jest wielokrotnością 4, więc każdy liczy pełne paczki SSE
+    TransformJob job = { set, indices, PV, mvpOut, mOut };
+    threadPoolFor(pool, transformComputeChunk, &job, count, TRANSFORM_MIN_PER_THREAD);
+}
+
+#endif